@@ -0,0 +1,99 @@
+#include "AllocCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace alloc {
+
+namespace {
+
+// Plain thread_local integers: constant-initialized, so operator new can
+// use them before anything else in the thread has run.
+thread_local std::uint64_t allocationCount = 0;
+thread_local std::uint64_t allocatedBytes = 0;
+thread_local std::uint64_t freeCount = 0;
+
+} // namespace
+
+bool enabled() {
+#ifdef STOMP_ALLOC_ACCOUNTING
+    return true;
+#else
+    return false;
+#endif
+}
+
+Counts current() {
+    return {allocationCount, allocatedBytes, freeCount};
+}
+
+#ifdef STOMP_ALLOC_ACCOUNTING
+
+namespace {
+
+void* allocate(std::size_t size) {
+    ++allocationCount;
+    allocatedBytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void release(void* pointer) {
+    if (pointer == nullptr) return;
+    ++freeCount;
+    std::free(pointer);
+}
+
+} // namespace
+
+#endif
+
+} // namespace alloc
+
+#ifdef STOMP_ALLOC_ACCOUNTING
+
+void* operator new(std::size_t size) {
+    void* pointer = alloc::allocate(size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](std::size_t size) {
+    void* pointer = alloc::allocate(size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc::allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return alloc::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    alloc::release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    alloc::release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    alloc::release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    alloc::release(pointer);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* pointer, std::size_t) noexcept {
+    alloc::release(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+    alloc::release(pointer);
+}
+#endif
+
+#endif
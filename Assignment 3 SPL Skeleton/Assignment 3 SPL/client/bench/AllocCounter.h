@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocation counts of the calling thread. AllocCounter.cpp built with
+// -DSTOMP_ALLOC_ACCOUNTING replaces the global operator new/delete to keep
+// them; without it enabled() is false and every count stays zero.
+namespace alloc {
+
+struct Counts {
+    std::uint64_t allocations;
+    std::uint64_t bytes;
+    std::uint64_t frees;
+};
+
+bool enabled();
+
+// Running totals of this thread since it started.
+Counts current();
+
+// Allocations made by this thread between construction and elapsed().
+class Scope {
+public:
+    Scope() : start(current()) {}
+
+    Counts elapsed() const {
+        Counts now = current();
+        return {now.allocations - start.allocations, now.bytes - start.bytes, now.frees - start.frees};
+    }
+
+private:
+    Counts start;
+};
+
+} // namespace alloc
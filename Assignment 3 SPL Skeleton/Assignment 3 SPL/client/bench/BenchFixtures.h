@@ -0,0 +1,54 @@
+#pragma once
+#include "../include/StompFrame.h"
+#include "../include/event.h"
+#include <map>
+#include <string>
+
+// Synthetic events and frames shared by the benchmarks and the perf gate
+// in ../tests/test_runner.cpp.
+
+namespace bench {
+
+const char* const EVENT_NAMES[] = {"kickoff", "goal!!!!", "possession change", "halftime", "shot on target",
+                                   "final whistle"};
+
+// Event number index of a Germany vs Japan game (or teamA vs teamB), index * 10
+// seconds in. Every 50th event has a "weather" update, for the key index.
+inline Event makeEvent(int index, const std::string& owner, const std::string& teamA = "Germany",
+                       const std::string& teamB = "Japan") {
+    std::map<std::string, std::string> general;
+    std::map<std::string, std::string> teamAUpdates;
+    std::map<std::string, std::string> teamBUpdates;
+    general["active"] = "true";
+    general["before halftime"] = index < 500 ? "true" : "false";
+    if (index % 50 == 0) general["weather"] = "rain";
+    teamAUpdates["goals"] = std::to_string(index % 5);
+    teamAUpdates["possession"] = std::to_string(40 + index % 20) + "%";
+    teamBUpdates["possession"] = std::to_string(60 - index % 20) + "%";
+    Event event(teamA, teamB, EVENT_NAMES[index % 6], index * 10, general, teamAUpdates, teamBUpdates,
+                "Something happened on the pitch at minute " + std::to_string(index) + ".");
+    event.set_event_owner(owner);
+    return event;
+}
+
+// Teams and canonical game name of synthetic game number game, for stores
+// with many games.
+inline std::string teamName(int game, char side) {
+    return "Team" + std::to_string(game) + side;
+}
+
+inline std::string gameName(int game) {
+    return "team" + std::to_string(game) + "a_team" + std::to_string(game) + "b";
+}
+
+// MESSAGE frame as the server relays a report of event to Germany_Japan,
+// without the trailing NUL.
+inline std::string makeMessageFrame(const Event& event, int messageId) {
+    std::string frame;
+    appendReportFrame(frame, "Germany_Japan", event.get_event_owner(), event);
+    frame.pop_back();
+    frame.replace(0, 4, "MESSAGE\nsubscription:0\nmessage-id:" + std::to_string(messageId));
+    return frame;
+}
+
+} // namespace bench
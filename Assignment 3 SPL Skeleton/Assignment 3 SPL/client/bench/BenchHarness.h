@@ -0,0 +1,185 @@
+#pragma once
+#include "AllocCounter.h"
+#include "../include/json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal microbenchmark harness. Each case is a body run for a given
+// number of operations; the harness grows that number until one sample
+// takes at least --min-time-ms, then times --samples samples and reports
+// per-operation nanoseconds (median, min, max).
+//
+// Results are printed as JSON with sorted keys, cases in registration
+// order and rounded numbers, so two runs can be diffed directly.
+//
+// In the allocation-accounting build (`make bench-alloc`) each case also
+// reports heap allocations and bytes per operation, counted on the
+// benchmark thread over one extra pass.
+// Usage: <bench> [--filter text] [--samples n] [--min-time-ms ms] [--out path]
+// A bench may declare integer options of its own (see Suite::option); their
+// values are reported in the context next to the harness settings.
+
+namespace bench {
+
+// Keeps the compiler from discarding a computed value.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Three significant digits keep reruns comparable without noise digits.
+inline double rounded(double value) {
+    if (value <= 0) return 0;
+    double scale = std::pow(10.0, 2 - std::floor(std::log10(value)));
+    return std::round(value * scale) / scale;
+}
+
+// Throughput units of one operation; zero means "not reported".
+struct Units {
+    double items;
+    double bytes;
+};
+
+class Suite {
+public:
+    // extraOptions maps each bench-specific flag to its default value.
+    Suite(int argc, char* argv[], std::map<std::string, long long> extraOptions = std::map<std::string, long long>())
+        : filter(), outPath(), samples(7), minTimeMs(50), options(extraOptions), results(nlohmann::json::array()) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--filter") filter = value;
+            else if (flag == "--samples") samples = std::max(1, std::atoi(value.c_str()));
+            else if (flag == "--min-time-ms") minTimeMs = std::max(1.0, std::atof(value.c_str()));
+            else if (flag == "--out") outPath = value;
+            else if (options.count(flag)) options[flag] = std::atoll(value.c_str());
+            else std::cerr << "ignoring unknown option " << flag << std::endl;
+        }
+    }
+
+    // Value of a flag declared in the constructor's extraOptions.
+    long long option(const std::string& flag) const { return options.at(flag); }
+
+    bool selected(const std::string& name) const { return filter.empty() || name.find(filter) != std::string::npos; }
+
+    // body(n) must perform n operations.
+    template <typename Body>
+    void run(const std::string& name, Units units, Body body) {
+        if (!selected(name)) return;
+
+        body(1); // warm-up
+        std::size_t iterations = 1;
+        double sampleMs = timeMs(body, iterations);
+        while (sampleMs < minTimeMs && iterations < (std::size_t(1) << 40)) {
+            double scale = sampleMs <= 0 ? 10 : std::min(10.0, 1.2 * minTimeMs / sampleMs);
+            iterations = std::max(iterations + 1, static_cast<std::size_t>(iterations * scale));
+            sampleMs = timeMs(body, iterations);
+        }
+
+        std::vector<double> nsPerOp;
+        for (int s = 0; s < samples; ++s) {
+            nsPerOp.push_back(timeMs(body, iterations) * 1e6 / static_cast<double>(iterations));
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        double median = nsPerOp[nsPerOp.size() / 2];
+
+        alloc::Counts allocated = {0, 0, 0};
+        if (alloc::enabled()) {
+            alloc::Scope scope;
+            body(iterations);
+            allocated = scope.elapsed();
+        }
+
+        nlohmann::json result;
+        result["name"] = name;
+        result["iterations"] = iterations;
+        result["samples"] = samples;
+        result["ns_per_op"] = {{"median", rounded(median)}, {"min", rounded(nsPerOp.front())}, {"max", rounded(nsPerOp.back())}};
+        if (units.items > 0) result["items_per_sec"] = rounded(units.items * 1e9 / median);
+        if (units.bytes > 0) result["mb_per_sec"] = rounded(units.bytes * 1e9 / median / (1 << 20));
+        double ops = static_cast<double>(iterations);
+        if (alloc::enabled()) {
+            result["allocs_per_op"] = rounded(allocated.allocations / ops);
+            result["alloc_bytes_per_op"] = rounded(allocated.bytes / ops);
+        }
+        results.push_back(result);
+
+        std::cerr << name << ": " << median << " ns/op (" << iterations << " ops x " << samples << ")";
+        if (alloc::enabled()) std::cerr << ", " << allocated.allocations / ops << " allocs/op";
+        std::cerr << std::endl;
+    }
+
+    // Writes the JSON report to --out (or stdout) and returns the exit code.
+    int finish() const {
+        nlohmann::json report;
+        report["schema"] = "stomp-bench/1";
+        report["context"] = {{"compiler", __VERSION__},
+                             {"samples", samples},
+                             {"min_time_ms", minTimeMs},
+                             {"alloc_accounting", alloc::enabled()},
+#ifdef NDEBUG
+                             {"optimized", true}
+#else
+                             {"optimized", false}
+#endif
+        };
+        for (const auto& option : options) {
+            std::string key = option.first.substr(2); // "--store-events" -> "store_events"
+            std::replace(key.begin(), key.end(), '-', '_');
+            report["context"][key] = option.second;
+        }
+        report["results"] = results;
+
+        if (outPath.empty()) {
+            std::cout << report.dump(2) << std::endl;
+            return 0;
+        }
+        std::ofstream out(outPath);
+        out << report.dump(2) << std::endl;
+        if (!out) {
+            std::cerr << "Could not write " << outPath << std::endl;
+            return 1;
+        }
+        std::cerr << "results written to " << outPath << std::endl;
+        return 0;
+    }
+
+private:
+    template <typename Body>
+    static double timeMs(Body& body, std::size_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string filter;
+    std::string outPath;
+    int samples;
+    double minTimeMs;
+    std::map<std::string, long long> options;
+    nlohmann::json results;
+};
+
+// Silences std::cout (the protocol's user-facing messages) for its lifetime.
+class MuteStdout {
+public:
+    MuteStdout() : saved(std::cout.rdbuf(nullptr)) {}
+    ~MuteStdout() {
+        std::cout.rdbuf(saved);
+        std::cout.clear();
+    }
+    MuteStdout(const MuteStdout&) = delete;
+    MuteStdout& operator=(const MuteStdout&) = delete;
+
+private:
+    std::streambuf* saved;
+};
+
+} // namespace bench
@@ -0,0 +1,416 @@
+#include "BenchFixtures.h"
+#include "BenchHarness.h"
+#include "../include/ConnectionHandler.h"
+#include "../include/EventIndex.h"
+#include "../include/EventLog.h"
+#include "../include/EventSnapshot.h"
+#include "../include/FileUtil.h"
+#include "../include/LoopbackBroker.h"
+#include "../include/StompFrame.h"
+#include "../include/StompProtocol.h"
+#include "../include/SummaryRenderer.h"
+#include "../include/Timeline.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <initializer_list>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Microbenchmarks of the client hot paths, reported as JSON (see
+// BenchHarness.h). `make bench` runs them all.
+// Usage: MicroBench [--filter text] [--samples n] [--min-time-ms ms] [--out path]
+//                   [--store-events n]
+// --store-events sizes the store the snapshot and index cases work on
+// (default 1,000,000, the size their startup and query targets are set for).
+
+class ProtocolBenchAccess {
+public:
+    explicit ProtocolBenchAccess(StompProtocol& protocol) : protocol(protocol) {}
+    GameId game(const std::string& canonical) { return protocol.gameIds.intern(canonical); }
+    void store(GameId game, const Event& event) { protocol.storeEvent(game, event); }
+    void clear(GameId game, const std::string& owner) { protocol.clearTimeline(game, owner); }
+
+private:
+    StompProtocol& protocol;
+};
+
+namespace {
+
+using bench::makeEvent;
+using bench::makeMessageFrame;
+
+const std::size_t TIMELINE_LENGTH = 1000;
+// Events in the store the event log cases replay; each restore rebuilds it
+// from scratch, so it stays small.
+const std::size_t EVENT_LOG_STORE_EVENTS = 40000;
+const char* const STORE_OWNERS[] = {"alice", "bob"};
+
+// One timeline of TIMELINE_LENGTH events per game and owner, store[2 * game + owner],
+// with as many games as it takes to hold about events events.
+std::vector<std::vector<Event>> makeStore(std::size_t events) {
+    int games = static_cast<int>(std::max<std::size_t>(1, events / (2 * TIMELINE_LENGTH)));
+    std::vector<std::vector<Event>> store;
+    store.reserve(2 * games);
+    for (int g = 0; g < games; ++g) {
+        for (const char* owner : STORE_OWNERS) {
+            store.push_back(std::vector<Event>());
+            store.back().reserve(TIMELINE_LENGTH);
+            for (std::size_t i = 0; i < TIMELINE_LENGTH; ++i) {
+                store.back().push_back(
+                    makeEvent(static_cast<int>(i), owner, bench::teamName(g, 'a'), bench::teamName(g, 'b')));
+            }
+        }
+    }
+    return store;
+}
+
+bool anySelected(const bench::Suite& suite, std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+        if (suite.selected(name)) return true;
+    }
+    return false;
+}
+
+std::string tempPath(const std::string& suffix) {
+    return "/tmp/stomp_microbench_" + std::to_string(getpid()) + suffix;
+}
+
+void benchGetFrameAscii(bench::Suite& suite) {
+    if (!suite.selected("connection.getFrameAscii")) return;
+    int fds[2];
+    if (!loopbackTcpPair(fds)) {
+        std::cerr << "connection.getFrameAscii: could not connect over 127.0.0.1" << std::endl;
+        return;
+    }
+
+    std::string frame = makeMessageFrame(makeEvent(7, "bob"), 1);
+    std::string stream;
+    for (int i = 0; i < 64; ++i) {
+        stream += frame;
+        stream.push_back('\0');
+    }
+
+    // Keeps the socket full until the reader side is shut down.
+    std::thread writer([&] {
+        while (true) {
+            std::size_t sent = 0;
+            while (sent < stream.size()) {
+                ssize_t n = ::send(fds[1], stream.data() + sent, stream.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) return;
+                sent += static_cast<std::size_t>(n);
+            }
+        }
+    });
+
+    {
+        ConnectionHandler handler("127.0.0.1", 0);
+        handler.adopt(fds[0]);
+        std::string received;
+        suite.run("connection.getFrameAscii", {1, static_cast<double>(frame.size() + 1)}, [&](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                received.clear();
+                handler.getFrameAscii(received, '\0');
+            }
+            bench::doNotOptimize(received);
+        });
+        ::shutdown(fds[1], SHUT_RDWR);
+        writer.join();
+    }
+    ::close(fds[1]);
+}
+
+// One report through the in-process broker: SEND with a receipt, then the
+// MESSAGE it fans back out (the sender is subscribed) and the RECEIPT.
+void benchLoopbackRoundTrip(bench::Suite& suite) {
+    if (!suite.selected("loopback.roundTrip")) return;
+    LoopbackBroker broker;
+    int fd = broker.connectPair();
+    if (fd < 0) {
+        std::cerr << "loopback.roundTrip: could not connect to the broker" << std::endl;
+        return;
+    }
+    ConnectionHandler handler("127.0.0.1", 0);
+    handler.adopt(fd);
+    std::string reply;
+    handler.sendFrameAscii("CONNECT\naccept-version:1.2\nhost:stomp.cs.bgu.ac.il\nlogin:alice\npasscode:pass\n\n", '\0');
+    handler.getFrameAscii(reply, '\0');
+    reply.clear();
+    handler.sendFrameAscii("SUBSCRIBE\ndestination:/Germany_Japan\nid:0\nreceipt:0\n\n", '\0');
+    handler.getFrameAscii(reply, '\0');
+
+    std::string send;
+    appendReportFrame(send, "Germany_Japan", "alice", makeEvent(7, "alice"));
+    send.pop_back();
+    send.insert(5, "receipt:1\n");
+    reply.clear();
+    handler.sendFrameAscii(send, '\0');
+    handler.getFrameAscii(reply, '\0');
+    if (reply.compare(0, 8, "MESSAGE\n") != 0) {
+        std::cerr << "loopback.roundTrip: unexpected reply " << reply.substr(0, reply.find('\n')) << std::endl;
+        return;
+    }
+    reply.clear();
+    handler.getFrameAscii(reply, '\0');
+    suite.run("loopback.roundTrip", {1, static_cast<double>(send.size() + 1)}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            handler.sendFrameAscii(send, '\0');
+            reply.clear();
+            handler.getFrameAscii(reply, '\0');
+            reply.clear();
+            handler.getFrameAscii(reply, '\0');
+        }
+        bench::doNotOptimize(reply);
+    });
+    handler.close();
+}
+
+void benchProcessResponse(bench::Suite& suite) {
+    std::vector<std::string> frames;
+    std::size_t bytes = 0;
+    for (int i = 0; i < 256; ++i) {
+        frames.push_back(makeMessageFrame(makeEvent(i % 50, "bob" + std::to_string(i % 4)), i));
+        frames.back().push_back('\0');
+        bytes += frames.back().size();
+    }
+
+    bench::MuteStdout mute;
+    StompProtocol protocol;
+    protocol.processInput("login 127.0.0.1:7777 alice pass");
+    protocol.processInput("join Germany_Japan");
+    std::size_t next = 0;
+    suite.run("protocol.processResponse.message", {1, static_cast<double>(bytes) / frames.size()}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            protocol.processResponse(frames[next]);
+            next = (next + 1) % frames.size();
+        }
+    });
+}
+
+void benchEncodeReport(bench::Suite& suite) {
+    std::vector<Event> events;
+    for (int i = 0; i < 64; ++i) events.push_back(makeEvent(i, "alice"));
+    std::size_t bytes = 0;
+    for (const Event& event : events) bytes += reportFrameSize("Germany_Japan", "alice", event);
+
+    std::string out;
+    std::size_t next = 0;
+    suite.run("frame.encodeReport", {1, static_cast<double>(bytes) / events.size()}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const Event& event = events[next];
+            next = (next + 1) % events.size();
+            out.clear();
+            out.reserve(reportFrameSize("Germany_Japan", "alice", event));
+            appendReportFrame(out, "Germany_Japan", "alice", event);
+            bench::doNotOptimize(out);
+        }
+    });
+}
+
+// One operation stores one event; the timeline is cleared every
+// TIMELINE_LENGTH events so its length stays bounded.
+void benchStoreEvent(bench::Suite& suite) {
+    std::vector<Event> events;
+    for (std::size_t i = 0; i < TIMELINE_LENGTH; ++i) events.push_back(makeEvent(static_cast<int>(i), "alice"));
+
+    StompProtocol protocol;
+    ProtocolBenchAccess access(protocol);
+    GameId game = access.game("germany_japan");
+    std::size_t next = 0;
+    suite.run("protocol.storeEvent", {1, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (next == events.size()) {
+                access.clear(game, "alice");
+                next = 0;
+            }
+            access.store(game, events[next++]);
+        }
+    });
+}
+
+void benchParseEventsFile(bench::Suite& suite) {
+    const std::string path = "data/events1.json";
+    std::ifstream probe(path, std::ios::ate | std::ios::binary);
+    if (!probe) {
+        if (suite.selected("events.parseEventsFile")) std::cerr << "events.parseEventsFile: " << path << " not found" << std::endl;
+        return;
+    }
+    double bytes = static_cast<double>(probe.tellg());
+    suite.run("events.parseEventsFile", {0, bytes}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            names_and_events parsed = parseEventsFile(path);
+            bench::doNotOptimize(parsed);
+        }
+    });
+}
+
+void benchSummary(bench::Suite& suite) {
+    Timeline timeline;
+    for (std::size_t i = 0; i < TIMELINE_LENGTH; ++i) timeline.append(makeEvent(static_cast<int>(i), "alice"));
+    std::vector<const Event*> ordered;
+    for (const Event& event : timeline.events) ordered.push_back(&event);
+    std::string contents = renderSummary("Germany", "Japan", timeline, ordered);
+
+    suite.run("summary.render", {0, static_cast<double>(contents.size())}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::string rendered = renderSummary("Germany", "Japan", timeline, ordered);
+            bench::doNotOptimize(rendered);
+        }
+    });
+
+    std::string path = tempPath(".summary.txt");
+    suite.run("summary.write", {0, static_cast<double>(contents.size())}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) replaceFileContents(path, contents);
+    });
+    std::remove(path.c_str());
+}
+
+// eventlog.append commits one event per operation; replay and restore read
+// back a log of the whole store, the second into a fresh StompProtocol.
+void benchEventLog(bench::Suite& suite) {
+    if (!anySelected(suite, {"eventlog.append", "eventlog.replay", "eventlog.restore"})) return;
+    std::vector<std::vector<Event>> store = makeStore(EVENT_LOG_STORE_EVENTS);
+    std::string path = tempPath(".log");
+    std::remove(path.c_str());
+    EventLog log;
+    if (!log.open(path, EventLog::ReplayHandler())) {
+        std::cerr << "eventlog: could not open " << path << std::endl;
+        return;
+    }
+
+    std::size_t next = 0;
+    suite.run("eventlog.append", {1, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::vector<Event>& timeline = store[next / TIMELINE_LENGTH];
+            log.appendEvent(bench::gameName(static_cast<int>(next / TIMELINE_LENGTH / 2)), timeline[next % TIMELINE_LENGTH]);
+            next = (next + 1) % (store.size() * TIMELINE_LENGTH);
+        }
+        log.flush();
+    });
+
+    log.truncate();
+    for (std::size_t t = 0; t < store.size(); ++t) {
+        for (const Event& event : store[t]) log.appendEvent(bench::gameName(static_cast<int>(t / 2)), event);
+    }
+    log.close();
+    double events = static_cast<double>(store.size() * TIMELINE_LENGTH);
+    std::ifstream probe(path, std::ios::ate | std::ios::binary);
+    double bytes = static_cast<double>(probe.tellg());
+
+    std::size_t replayed = 0;
+    EventLog::ReplayHandler counter;
+    counter.onEvent = [&](const std::string&, const Event&) { ++replayed; };
+    suite.run("eventlog.replay", {events, bytes}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) EventLog::replay(path, counter);
+        bench::doNotOptimize(replayed);
+    });
+
+    bench::MuteStdout mute;
+    suite.run("eventlog.restore", {events, bytes}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            StompProtocol protocol;
+            protocol.openEventLog(path);
+            protocol.closeEventLog();
+        }
+    });
+    std::remove(path.c_str());
+}
+
+// snapshot.summary is a warm start: map the snapshot, then serve the first
+// summary, which materializes one game.
+void benchSnapshot(bench::Suite& suite) {
+    if (!anySelected(suite, {"snapshot.write", "snapshot.load", "snapshot.summary"})) return;
+    std::vector<std::vector<Event>> store = makeStore(static_cast<std::size_t>(suite.option("--store-events")));
+    EventSnapshotWriter writer;
+    for (std::size_t t = 0; t < store.size(); ++t) {
+        writer.addTimeline(bench::gameName(static_cast<int>(t / 2)), STORE_OWNERS[t % 2], store[t]);
+    }
+    std::string path = tempPath(".snap");
+    if (!writer.write(path)) {
+        std::cerr << "snapshot: could not write " << path << std::endl;
+        return;
+    }
+
+    double events = static_cast<double>(store.size() * TIMELINE_LENGTH);
+    suite.run("snapshot.write", {events, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) writer.write(path);
+    });
+
+    bench::MuteStdout mute;
+    suite.run("snapshot.load", {events, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            StompProtocol protocol;
+            protocol.loadSnapshot(path);
+        }
+    });
+
+    std::string summaryPath = tempPath(".snap.summary.txt");
+    suite.run("snapshot.summary", {0, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            StompProtocol protocol;
+            protocol.loadSnapshot(path);
+            protocol.processInput("login 127.0.0.1:7777 alice pass");
+            protocol.processInput("summary " + bench::gameName(0) + " alice " + summaryPath);
+        }
+    });
+    std::remove(summaryPath.c_str());
+    std::remove(path.c_str());
+}
+
+// index.build indexes the whole store per operation; the lookups run
+// against one index of it.
+void benchEventIndex(bench::Suite& suite) {
+    if (!anySelected(suite, {"index.build", "index.byStatKey", "index.byNameToken", "index.byNamePrefix",
+                             "index.byTimeRange"})) {
+        return;
+    }
+    std::vector<std::vector<Event>> store = makeStore(static_cast<std::size_t>(suite.option("--store-events")));
+    auto build = [&](EventIndex& index) {
+        for (std::size_t t = 0; t < store.size(); ++t) {
+            for (std::size_t i = 0; i < store[t].size(); ++i) {
+                index.add(bench::gameName(static_cast<int>(t / 2)), STORE_OWNERS[t % 2], store[t], i);
+            }
+        }
+    };
+
+    suite.run("index.build", {static_cast<double>(store.size() * TIMELINE_LENGTH), 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            EventIndex index;
+            build(index);
+            bench::doNotOptimize(index);
+        }
+    });
+
+    EventIndex index;
+    build(index);
+    suite.run("index.byStatKey", {0, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) bench::doNotOptimize(index.byStatKey("weather"));
+    });
+    suite.run("index.byNameToken", {0, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) bench::doNotOptimize(index.byNameToken("kickoff", false));
+    });
+    suite.run("index.byNamePrefix", {0, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) bench::doNotOptimize(index.byNameToken("fin", true));
+    });
+    suite.run("index.byTimeRange", {0, 0}, [&](std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) bench::doNotOptimize(index.byTimeRange(4800, 4830));
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Suite suite(argc, argv, {{"--store-events", 1000000}});
+    benchGetFrameAscii(suite);
+    benchLoopbackRoundTrip(suite);
+    benchProcessResponse(suite);
+    benchEncodeReport(suite);
+    benchStoreEvent(suite);
+    benchParseEventsFile(suite);
+    benchSummary(suite);
+    benchEventLog(suite);
+    benchSnapshot(suite);
+    benchEventIndex(suite);
+    return suite.finish();
+}
@@ -0,0 +1,75 @@
+#include "../include/event.h"
+#include "../include/json.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+// Compares the ways parseEventsFile can feed the JSON parser, on a copy of
+// data/events1.json whose events array is repeated up to the target size.
+// Usage: ParseEventsBench [target-megabytes] [source-json]
+
+using json = nlohmann::json;
+
+static std::string buildScaledFile(const std::string& source, std::size_t targetBytes) {
+    std::ifstream in(source);
+    json original = json::parse(in);
+    std::size_t perRound = original.dump(4).size();
+
+    json scaled = original;
+    scaled["events"] = json::array();
+    std::size_t rounds = targetBytes / perRound + 1;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        for (const json& event : original["events"]) {
+            scaled["events"].push_back(event);
+        }
+    }
+
+    std::string path = "/tmp/stomp_parse_bench_" + std::to_string(getpid()) + ".json";
+    std::ofstream out(path);
+    out << scaled.dump(4);
+    return path;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t megabytes = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 100;
+    std::string source = argc > 2 ? argv[2] : "data/events1.json";
+    std::string path = buildScaledFile(source, megabytes << 20);
+
+    std::ifstream sizeProbe(path, std::ios::ate | std::ios::binary);
+    double fileMegabytes = static_cast<double>(sizeProbe.tellg()) / (1 << 20);
+    std::cout << "file: " << path << " (" << fileMegabytes << " MB)" << std::endl;
+
+    struct Mode {
+        const char* name;
+        EventsFileReader reader;
+    };
+    const Mode modes[] = {{"ifstream", EventsFileReader::Stream},
+                          {"read-into-buffer", EventsFileReader::Buffer},
+                          {"mmap", EventsFileReader::Mmap}};
+
+    for (const Mode& mode : modes) {
+        auto start = std::chrono::steady_clock::now();
+        names_and_events parsed = parseEventsFile(path, mode.reader);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << mode.name << ": " << seconds * 1000 << " ms, " << fileMegabytes / seconds << " MB/s, "
+                  << parsed.events.size() << " events" << std::endl;
+    }
+
+    // JSON DOM construction alone, to separate parser cost from Event building.
+    std::string contents;
+    {
+        std::ifstream in(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto start = std::chrono::steady_clock::now();
+    json dom = json::parse(contents);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "json::parse only: " << seconds * 1000 << " ms, " << fileMegabytes / seconds << " MB/s" << std::endl;
+
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Where a broker's frames go. Implemented by each transport; frames have
+// no trailing NUL. send may be called from any connection's thread.
+class BrokerOutput {
+public:
+    virtual ~BrokerOutput() {}
+    virtual void send(int connectionId, const std::string& frame) = 0;
+};
+
+// STOMP 1.2 broker logic without any I/O: CONNECT, SUBSCRIBE, UNSUBSCRIBE,
+// SEND and DISCONNECT with receipts, with the frames, error messages and
+// login rules of the Java server (StompMessagingProtocolImpl and
+// ConnectionsImpl). Users are kept in memory only.
+//
+// Subscriber lists are copy-on-write: SEND takes the lock just long enough
+// to grab the current list and fans out without it.
+class BrokerCore {
+public:
+    // Per-connection state. Only the thread handling that connection may use it.
+    class Session {
+    public:
+        explicit Session(int connectionId)
+            : connectionId(connectionId), loggedIn(false), username(), destinationsById(), idsByDestination() {}
+
+        int id() const { return connectionId; }
+
+    private:
+        friend class BrokerCore;
+        int connectionId;
+        bool loggedIn;
+        std::string username;
+        std::map<std::string, std::string> destinationsById;
+        std::map<std::string, std::string> idsByDestination;
+    };
+
+    explicit BrokerCore(BrokerOutput& output);
+    BrokerCore(const BrokerCore&) = delete;
+    BrokerCore& operator=(const BrokerCore&) = delete;
+
+    // Handles one frame (without its NUL). Returns false once the connection
+    // should be closed: after an ERROR or the RECEIPT of a DISCONNECT.
+    bool handle(Session& session, const std::string& frame);
+
+    // Drops the session's subscriptions and login; call when its connection closes.
+    void close(Session& session);
+
+private:
+    struct Subscriber {
+        int connectionId;
+        std::string subscriptionId;
+    };
+    typedef std::vector<Subscriber> SubscriberList;
+
+    bool error(Session& session, const std::string& message, const std::string& receipt, const std::string& frame);
+    void receipt(Session& session, const std::string& receiptId);
+    // Caller holds stateMutex.
+    void removeSubscriber(const std::string& destination, int connectionId);
+
+    BrokerOutput& output;
+    std::mutex stateMutex;
+    std::map<std::string, std::string> passwords;
+    std::map<std::string, int> activeUsers;
+    std::map<std::string, std::shared_ptr<const SubscriberList>> channels;
+    std::atomic<std::uint64_t> nextMessageId;
+};
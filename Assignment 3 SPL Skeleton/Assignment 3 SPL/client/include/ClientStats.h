@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "Trace.h"
+
+// Process-wide hot-path counters. Every thread writes only its own slot
+// (a relaxed load and store, no locked read-modify-write), and read() sums
+// the slots of all threads that ever recorded anything, so the counters
+// are cheap enough to leave on.
+namespace stats {
+
+enum Counter {
+    FRAMES_CONNECTED,
+    FRAMES_RECEIPT,
+    FRAMES_MESSAGE,
+    FRAMES_ERROR,
+    FRAMES_OTHER,
+    FRAMES_SENT,
+    EVENTS_STORED,
+    EVENTS_REPLACED,
+    LOCK_ACQUIRED,
+    LOCK_CONTENDED,
+    COUNTER_COUNT
+};
+
+enum Timer {
+    TIMER_PROCESS_RESPONSE,
+    TIMER_LOCK_WAIT,
+    TIMER_RECEIPT_RTT,
+    TIMER_COUNT
+};
+
+struct TimerTotals {
+    std::uint64_t count;
+    std::uint64_t totalNanos;
+    std::uint64_t maxNanos;
+};
+
+struct Snapshot {
+    std::uint64_t counters[COUNTER_COUNT];
+    TimerTotals timers[TIMER_COUNT];
+    // Frames waiting to be written by the current send batch, and the most
+    // there have ever been.
+    std::uint64_t sendQueueDepth;
+    std::uint64_t sendQueueDepthMax;
+};
+
+void count(Counter counter, std::uint64_t amount = 1);
+void recordTime(Timer timer, std::uint64_t nanos);
+void setSendQueueDepth(std::uint64_t depth);
+Snapshot read();
+
+// lock_guard for _mutex that also counts contention. The uncontended path
+// is a try_lock; only a failed one reads the clock.
+class CountedLock {
+public:
+    explicit CountedLock(std::mutex& mutex) : mutex(mutex) {
+        count(LOCK_ACQUIRED);
+        if (mutex.try_lock()) return;
+        std::uint64_t start = monotonicNanos();
+        {
+            trace::Span span("lock wait");
+            mutex.lock();
+        }
+        count(LOCK_CONTENDED);
+        recordTime(TIMER_LOCK_WAIT, monotonicNanos() - start);
+    }
+    ~CountedLock() { mutex.unlock(); }
+    CountedLock(const CountedLock&) = delete;
+    CountedLock& operator=(const CountedLock&) = delete;
+
+private:
+    std::mutex& mutex;
+};
+
+// Records the lifetime of the scope under timer.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Timer timer) : timer(timer), start(monotonicNanos()) {}
+    ~ScopedTimer() { recordTime(timer, monotonicNanos() - start); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Timer timer;
+    std::uint64_t start;
+};
+
+// Runs task every interval on a background thread until stopped.
+class PeriodicTask {
+public:
+    PeriodicTask();
+    ~PeriodicTask();
+    PeriodicTask(const PeriodicTask&) = delete;
+    PeriodicTask& operator=(const PeriodicTask&) = delete;
+
+    // Replaces any running task.
+    void start(std::chrono::milliseconds interval, const std::function<void()>& task);
+    void stop();
+    bool running() const;
+
+private:
+    void loop(std::chrono::milliseconds interval, std::function<void()> task);
+
+    std::thread worker;
+    mutable std::mutex taskMutex;
+    std::condition_variable wake;
+    bool stopping;
+};
+
+} // namespace stats
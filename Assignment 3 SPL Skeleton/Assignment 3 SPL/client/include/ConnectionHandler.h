@@ -3,7 +3,9 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 #include <boost/asio.hpp>
+#include "FrameCapture.h"
 
 using boost::asio::ip::tcp;
 
@@ -13,14 +15,35 @@ private:
     const short port_;
     boost::asio::io_service io_service_;   // Provides core I/O functionality
     tcp::socket socket_;
+    // Bytes received but not yet consumed, readBuffer_[readStart_, readEnd_).
+    std::vector<char> readBuffer_;
+    std::size_t readStart_;
+    std::size_t readEnd_;
+    // Not owned; every frame getFrameAscii returns is recorded when set.
+    FrameCaptureWriter* capture_;
+
+    // Refill readBuffer_ with whatever the socket has (at least one byte).
+    bool fillReadBuffer();
 
 public:
     ConnectionHandler(std::string host, short port);
     virtual ~ConnectionHandler();
+    ConnectionHandler(const ConnectionHandler&) = delete;
+    ConnectionHandler& operator=(const ConnectionHandler&) = delete;
 
     // Connect to the remote machine
     bool connect();
 
+    // Take over an already connected TCP socket (e.g. from
+    // loopbackTcpPair) instead of connecting. Other sockets, such as AF_UNIX
+    // socketpairs, are refused and stay with the caller; once adopted the
+    // handler closes fd.
+    bool adopt(int fd);
+
+    // Record inbound frames into capture (nullptr stops). The caller keeps
+    // capture alive while it is set.
+    void setCapture(FrameCaptureWriter* capture);
+
     // Read a fixed number of bytes from the server - blocking.
     // Returns false in case the connection is closed before bytesToRead bytes can be read.
     bool getBytes(char bytes[], unsigned int bytesToRead);
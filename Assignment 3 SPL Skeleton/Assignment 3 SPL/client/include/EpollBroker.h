@@ -0,0 +1,43 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/BrokerCore.h"
+
+// BrokerCore served by one edge-triggered epoll reactor per thread (Linux).
+// Every reactor has its own SO_REUSEPORT listener on the port, so the kernel
+// shards new connections across them and a connection stays on the reactor
+// that accepted it. Fan-out to a connection on another reactor writes
+// straight to its socket under that connection's lock; whatever the socket
+// does not take is flushed by the owning reactor on EPOLLOUT.
+class EpollBroker : private BrokerOutput {
+public:
+    explicit EpollBroker(int threads);
+    ~EpollBroker();
+    EpollBroker(const EpollBroker&) = delete;
+    EpollBroker& operator=(const EpollBroker&) = delete;
+
+    // Listens on port (0 picks a free one) and starts the reactors. Returns
+    // the port, or 0 on failure.
+    int start(int port);
+
+    // Wakes the reactors, waits for them and closes every connection.
+    void stop();
+
+private:
+    struct Connection;
+    struct Reactor;
+
+    void send(int connectionId, const std::string& frame) override;
+    bool listenOn(Reactor& reactor, int& port);
+    void run(Reactor& reactor);
+    void acceptAll(Reactor& reactor);
+    void readAll(Reactor& reactor, const std::shared_ptr<Connection>& connection);
+    // After an ERROR or DISCONNECT: closes once the replies are written.
+    // Returns true if the connection is already closed.
+    bool finish(Reactor& reactor, const std::shared_ptr<Connection>& connection);
+    void closeConnection(Reactor& reactor, const std::shared_ptr<Connection>& connection);
+
+    BrokerCore core;
+    std::vector<std::unique_ptr<Reactor>> reactors;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../include/event.h"
+
+// Secondary indexes over the events held in StompProtocol's timelines:
+// by event-name token, by update (stat) key and by game time.
+//
+// Every indexed event occupies a slot that points back at its timeline and
+// position. Replacing or clearing events retires slots instead of editing
+// posting lists; lookups skip retired slots and the index is rebuilt once
+// retired slots outnumber live ones.
+class EventIndex {
+public:
+    struct Entry {
+        const std::string* game;
+        const std::string* owner;
+        const std::vector<Event>* timeline;
+        std::uint32_t position;
+        bool live;
+
+        const Event& event() const { return (*timeline)[position]; }
+    };
+
+    EventIndex();
+
+    // Index timeline[position], which was just appended.
+    void add(const std::string& game, const std::string& owner, const std::vector<Event>& timeline, std::size_t position);
+    // Re-index timeline[position] after it was overwritten in place.
+    void replace(const std::vector<Event>& timeline, std::size_t position);
+    // Forget every event of timeline; call before clearing it.
+    void removeTimeline(const std::vector<Event>& timeline);
+
+    // token is matched exactly, or as a prefix when prefix is true.
+    std::vector<const Entry*> byNameToken(const std::string& token, bool prefix) const;
+    std::vector<const Entry*> byStatKey(const std::string& key) const;
+    std::vector<const Entry*> byTimeRange(int from, int to) const;
+
+    std::size_t size() const;
+
+    // Lowercased alphanumeric runs of an event name ("Another goal!!!" ->
+    // "another", "goal").
+    static std::vector<std::string> nameTokens(const std::string& name);
+
+private:
+    std::uint32_t newSlot(const Entry& entry);
+    void indexSlot(std::uint32_t slot);
+    void retire(std::uint32_t slot);
+    void compactIfNeeded();
+    void collect(const std::vector<std::uint32_t>& postings, std::vector<const Entry*>& out) const;
+
+    std::vector<Entry> slots;
+    std::size_t retiredSlots;
+    std::map<std::string, std::vector<std::uint32_t>> nameIndex;
+    std::unordered_map<std::string, std::vector<std::uint32_t>> statIndex;
+    std::multimap<int, std::uint32_t> timeIndex;
+    std::unordered_map<const std::vector<Event>*, std::vector<std::uint32_t>> timelineSlots;
+};
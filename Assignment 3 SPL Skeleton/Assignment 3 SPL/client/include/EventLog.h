@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+#include "../include/event.h"
+
+// Append-only on-disk log of every event stored by the client.
+//
+// File layout: an 8 byte magic followed by records of the form
+//   [u32 payload length][u32 FNV-1a checksum][payload]
+// A record cut short at the end of the file is a torn write from a crash;
+// open() truncates it away. A complete record that fails its checksum or
+// does not decode is damage: open() refuses the log rather than cut off
+// the good records that may follow it.
+class EventLog {
+public:
+    enum RecordType : std::uint8_t {
+        RECORD_EVENT = 1,          // game, event (including owner)
+        RECORD_CLEAR_TIMELINE = 2  // game, owner
+    };
+
+    // Called once per event while replaying. onClearTimeline is invoked when
+    // a report replaced an owner's timeline for a game.
+    struct ReplayHandler {
+        ReplayHandler() : onEvent(), onClearTimeline() {}
+        std::function<void(const std::string& canonicalGame, const Event& event)> onEvent;
+        std::function<void(const std::string& canonicalGame, const std::string& owner)> onClearTimeline;
+    };
+
+    struct ReplayResult {
+        std::size_t events;
+        std::size_t records;
+        std::uint64_t validBytes;   // up to the end of the last good record
+        std::uint64_t unreadBytes;  // after validBytes, not replayed
+        bool truncatedTail;         // the unread bytes are a torn last record
+        bool damaged;               // the unread bytes start with a bad record
+    };
+
+    EventLog();
+    ~EventLog();
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    // Replay an existing log at path through handler, then open it for
+    // appending. Returns false if the file could not be opened or created,
+    // or is damaged (the records before the damage have been replayed).
+    bool open(const std::string& path, const ReplayHandler& handler, ReplayResult* result = nullptr);
+
+    bool isOpen() const;
+
+    // Queue a record; the writer thread commits queued records in batches.
+    void appendEvent(const std::string& canonicalGame, const Event& event);
+    void appendClearTimeline(const std::string& canonicalGame, const std::string& owner);
+
+    // Block until every record queued so far has been written and synced.
+    void flush();
+
+    // Flush, then drop every record; used once the store has been
+    // captured in a snapshot.
+    bool truncate();
+
+    // Flush and stop the writer thread.
+    void close();
+
+    // Read every record of the log at path. Does not require an open log.
+    static ReplayResult replay(const std::string& path, const ReplayHandler& handler);
+
+private:
+    void enqueue(const std::string& record);
+    void writerLoop();
+
+    int fd;
+    std::string pending;
+    std::uint64_t queuedSeq;
+    std::uint64_t committedSeq;
+    bool stopping;
+    bool writeFailed;
+    mutable std::mutex logMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable batchCommitted;
+    std::thread writer;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <cstdint>
+#include "../include/event.h"
+#include "../include/FileUtil.h"
+
+// Snapshot of the client's event store, laid out so it can be used
+// straight from a read-only mapping:
+//
+//   header | games | timelines | events | updates | string index | string data
+//
+// Every section is an array of fixed-size little structs; strings are
+// referenced by index into a deduplicated string table. Games own a range
+// of timelines (one per owner), timelines a range of events, events a range
+// of updates (general, then team a, then team b).
+namespace snapshot {
+
+const std::uint32_t VERSION = 1;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t gameCount;
+    std::uint32_t timelineCount;
+    std::uint32_t eventCount;
+    std::uint32_t updateCount;
+    std::uint32_t stringCount;
+    std::uint32_t reserved;
+    std::uint64_t gamesOffset;
+    std::uint64_t timelinesOffset;
+    std::uint64_t eventsOffset;
+    std::uint64_t updatesOffset;
+    std::uint64_t stringIndexOffset;
+    std::uint64_t stringDataOffset;
+    std::uint64_t stringDataSize;
+};
+
+struct StringEntry {
+    std::uint64_t offset;
+    std::uint32_t length;
+    std::uint32_t reserved;
+};
+
+struct GameEntry {
+    std::uint32_t name;
+    std::uint32_t firstTimeline;
+    std::uint32_t timelineCount;
+    std::uint32_t reserved;
+};
+
+struct TimelineEntry {
+    std::uint32_t owner;
+    std::uint32_t firstEvent;
+    std::uint32_t eventCount;
+    std::uint32_t reserved;
+};
+
+struct EventEntry {
+    std::uint32_t teamA;
+    std::uint32_t teamB;
+    std::uint32_t name;
+    std::int32_t time;
+    std::uint32_t description;
+    std::uint32_t owner;
+    std::uint32_t firstUpdate;
+    std::uint32_t gameUpdates;
+    std::uint32_t teamAUpdates;
+    std::uint32_t teamBUpdates;
+};
+
+struct UpdateEntry {
+    std::uint32_t key;
+    std::uint32_t value;
+};
+
+} // namespace snapshot
+
+// Collects timelines and writes them as a snapshot file in one atomic step.
+// Timelines of the same game must be added consecutively.
+class EventSnapshotWriter {
+public:
+    EventSnapshotWriter();
+
+    void addTimeline(const std::string& canonicalGame, const std::string& owner, const std::vector<Event>& events);
+    bool write(const std::string& path);
+
+private:
+    std::uint32_t intern(const std::string& value);
+    void addUpdates(const std::map<std::string, std::string>& updates);
+
+    std::vector<snapshot::GameEntry> games;
+    std::vector<snapshot::TimelineEntry> timelines;
+    std::vector<snapshot::EventEntry> events;
+    std::vector<snapshot::UpdateEntry> updates;
+    std::vector<snapshot::StringEntry> strings;
+    std::string stringData;
+    std::map<std::string, std::uint32_t> stringIds;
+    std::string currentGame;
+};
+
+// Read side of a snapshot. open() only maps the file and checks the
+// header; Event objects are built per game when materializeGame() is called.
+class EventSnapshot {
+public:
+    typedef std::function<void(const std::string& owner, std::vector<Event>& events)> TimelineSink;
+
+    EventSnapshot();
+    EventSnapshot(const EventSnapshot&) = delete;
+    EventSnapshot& operator=(const EventSnapshot&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+    bool isOpen() const;
+
+    std::size_t gameCount() const;
+    std::size_t eventCount() const;
+    std::string gameName(std::size_t game) const;
+
+    // Hands every timeline of the game to sink. Returns false if the
+    // game's records are inconsistent with the rest of the file.
+    bool materializeGame(std::size_t game, const TimelineSink& sink) const;
+
+private:
+    template <typename T>
+    const T* section(std::uint64_t offset) const;
+    bool string(std::uint32_t id, std::string& out) const;
+    bool readUpdates(std::uint64_t first, std::uint64_t count, std::map<std::string, std::string>& out) const;
+
+    MappedFile file;
+    const snapshot::Header* header;
+};
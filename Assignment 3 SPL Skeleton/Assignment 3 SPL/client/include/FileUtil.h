@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+struct stat;
+
+// Read-only memory mapping of a regular file.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if path is not a regular file or cannot be mapped.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const;
+    const char* data() const;
+    std::size_t size() const;
+
+private:
+    const char* mapped;
+    std::size_t length;
+    bool opened;
+};
+
+// Writes a file under a temporary name and renames it into place on
+// commit(), so readers see either the old contents or the complete new ones.
+// A writer destroyed without commit() removes its temporary file.
+class AtomicFileWriter {
+public:
+    AtomicFileWriter();
+    ~AtomicFileWriter();
+    AtomicFileWriter(const AtomicFileWriter&) = delete;
+    AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
+
+    bool open(const std::string& path);
+    // Give the temporary file existing's owner, group and permission bits,
+    // which the rename would otherwise reset. Returns false if it cannot.
+    bool copyAttributes(const struct stat& existing);
+    bool write(const char* data, std::size_t len);
+    // durable = false skips the fsync: readers still never see a partial
+    // file, but a crash right after may leave the old contents.
+    bool commit(bool durable = true);
+    void abort();
+
+private:
+    std::string finalPath;
+    std::string tempPath;
+    int fd;
+    bool failed;
+};
+
+// Replaces the contents of path with data. A regular file, or one that does
+// not exist yet, goes through AtomicFileWriter (without fsync) when a
+// temporary file can be created next to it and given the old file's owner
+// and mode. Anything else, e.g. a symlink or /dev/stdout, is truncated and
+// written in place so the link or device node itself is kept.
+bool replaceFileContents(const std::string& path, const std::string& data);
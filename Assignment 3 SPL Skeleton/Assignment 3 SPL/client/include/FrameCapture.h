@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include "../include/FileUtil.h"
+
+// Raw inbound frames with their arrival times, so a session can be fed
+// back into StompProtocol without a socket (tools/ReplayCapture.cpp).
+//
+// File layout: an 8 byte magic followed by records of the form
+//   [u64 nanoseconds since the capture was opened][u32 frame length][frame]
+// A record that is cut short ends the capture.
+class FrameCaptureWriter {
+public:
+    FrameCaptureWriter();
+    ~FrameCaptureWriter();
+    FrameCaptureWriter(const FrameCaptureWriter&) = delete;
+    FrameCaptureWriter& operator=(const FrameCaptureWriter&) = delete;
+
+    // Truncates path. Returns false if it cannot be created.
+    bool open(const std::string& path);
+    bool isOpen() const;
+    // Buffered; written out by close() or when the buffer fills.
+    void record(const std::string& frame);
+    void close();
+    std::uint64_t frames() const;
+
+private:
+    std::FILE* file;
+    std::uint64_t startNanos;
+    std::uint64_t recorded;
+    mutable std::mutex captureMutex;
+};
+
+class FrameCaptureReader {
+public:
+    struct Frame {
+        std::uint64_t offsetNanos;
+        const char* data;
+        std::size_t size;
+    };
+
+    FrameCaptureReader();
+    FrameCaptureReader(const FrameCaptureReader&) = delete;
+    FrameCaptureReader& operator=(const FrameCaptureReader&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    // frame points into the mapping and stays valid while the reader is open.
+    bool next(Frame& frame);
+    // Back to the first frame.
+    void rewind();
+    // True once next() has stopped at an incomplete record.
+    bool truncated() const;
+
+private:
+    MappedFile mapped;
+    std::size_t pos;
+    bool cutShort;
+};
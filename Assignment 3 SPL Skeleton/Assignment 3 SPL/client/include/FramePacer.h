@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+// Classic token bucket: tokens accrue at rate per second up to burst. A
+// request larger than what is available is let through once the bucket
+// has refilled enough, leaving it in debt for the next one.
+class TokenBucket {
+public:
+    TokenBucket();
+    void configure(double rate, double burst);
+    bool enabled() const;
+    // Takes tokens and returns the point in time the caller may proceed.
+    std::chrono::steady_clock::time_point acquire(double tokens, std::chrono::steady_clock::time_point now);
+
+private:
+    double rate;
+    double burst;
+    double available;
+    std::chrono::steady_clock::time_point lastRefill;
+};
+
+// Decides when each outgoing SEND frame may be written. Frames per second
+// and bytes per second are limited by token buckets; in replay mode the
+// frames of one game are additionally spaced by their "time:" field,
+// divided by the replay speed. A report may carry several games back to
+// back, each starting again at time 0, so the replay clock restarts when
+// the destination changes or the time goes backwards.
+class FramePacer {
+public:
+    struct Settings {
+        Settings() : framesPerSecond(0), bytesPerSecond(0), replaySpeed(0) {}
+        double framesPerSecond;  // 0 = unlimited
+        double bytesPerSecond;   // 0 = unlimited
+        double replaySpeed;      // 0 = off, 1 = real time, 60 = a minute per second
+    };
+
+    FramePacer();
+
+    void configure(const Settings& settings);
+    const Settings& settings() const;
+
+    // Parses "pace off" or "pace [frames=N] [bytes=N] [replay=SPEED]".
+    // Prints usage and returns false on malformed input.
+    bool configure(const std::string& command);
+
+    // Marks the start of a new batch of frames (one report).
+    void beginBatch();
+
+    // Blocks until frame may be sent.
+    void beforeSend(const std::string& frame);
+
+private:
+    static bool eventTime(const std::string& frame, long& time);
+    static std::string destination(const std::string& frame);
+
+    Settings current;
+    TokenBucket frames;
+    TokenBucket bytes;
+    bool batchStarted;
+    std::string replayDestination;
+    long replayFirstTime;
+    long replayLastTime;
+    std::chrono::steady_clock::time_point replayStart;
+};
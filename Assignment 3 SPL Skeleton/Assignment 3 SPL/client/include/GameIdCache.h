@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef int GameId;
+const GameId NO_GAME = -1;
+
+// Interns canonical game names as small integer ids and memoizes the
+// raw destination -> id mapping, so a destination seen before is resolved
+// with one hash and one memcmp instead of being normalized again.
+//
+// The raw cache is an open-addressing table over a byte arena. It grows up
+// to MAX_SLOTS and is then reset, which keeps it bounded no matter how many
+// distinct spellings the server sends. Ids and names are never dropped.
+class GameIdCache {
+public:
+    typedef std::string (*Normalizer)(const std::string& raw);
+
+    explicit GameIdCache(Normalizer normalize);
+
+    // Id for raw destination bytes, or NO_GAME if they normalize to nothing.
+    GameId resolve(const char* raw, std::size_t length);
+    // Id of a canonical name, allocating one the first time it is seen.
+    GameId intern(const std::string& canonical);
+    // Id of a canonical name seen before, or NO_GAME.
+    GameId find(const std::string& canonical) const;
+    // Canonical name of id; the reference stays valid for the cache's lifetime.
+    const std::string& name(GameId id) const;
+    std::size_t size() const;
+
+private:
+    struct Slot {
+        std::uint64_t hash;
+        std::uint32_t offset;
+        std::uint32_t length;
+        GameId id;
+        bool used;
+    };
+
+    static const std::size_t INITIAL_SLOTS = 64;
+    static const std::size_t MAX_SLOTS = 4096;
+
+    std::size_t probe(std::uint64_t hash, const char* raw, std::size_t length) const;
+    void insertRaw(std::uint64_t hash, const char* raw, std::size_t length, GameId id);
+    void rehash(std::size_t slotCount);
+
+    Normalizer normalize;
+    std::vector<Slot> slots;
+    std::size_t usedSlots;
+    std::string rawArena;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, GameId> ids;
+};
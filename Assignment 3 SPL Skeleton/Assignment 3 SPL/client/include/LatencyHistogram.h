@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram of latencies in nanoseconds: values below 32 are
+// exact, larger ones fall into 32 sub-buckets per power of two, so a
+// reported percentile is within about 3% of the recorded value. Fixed size
+// (about 15 KB) regardless of how many values are recorded.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(std::uint64_t nanos);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    std::uint64_t count() const;
+    std::uint64_t max() const;
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100),
+    // capped at max(); 0 if nothing was recorded.
+    std::uint64_t percentile(double p) const;
+
+private:
+    static std::size_t bucketOf(std::uint64_t nanos);
+    static std::uint64_t bucketUpperBound(std::size_t bucket);
+
+    std::vector<std::uint64_t> buckets;
+    std::uint64_t total;
+    std::uint64_t maxValue;
+};
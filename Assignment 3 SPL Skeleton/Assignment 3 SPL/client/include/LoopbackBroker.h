@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "../include/BrokerCore.h"
+
+// In-process STOMP broker over real sockets, so the client can be tested and
+// benchmarked end to end without the Java and SQL servers. Connections come
+// from connectPair() (a localhost TCP connection, for ConnectionHandler::adopt)
+// or from localhost clients once listen() has been called; each is served
+// by its own thread. Frames for a connection are queued and written by a
+// second thread, so fanning out to a client that is not reading never
+// blocks the sender's thread (and, through it, the sender).
+// Two ends of a new TCP connection over 127.0.0.1, fds[0] the accepted one,
+// both with TCP_NODELAY. Returns false if it could not be set up.
+bool loopbackTcpPair(int fds[2]);
+
+class LoopbackBroker : private BrokerOutput {
+public:
+    LoopbackBroker();
+    ~LoopbackBroker();
+    LoopbackBroker(const LoopbackBroker&) = delete;
+    LoopbackBroker& operator=(const LoopbackBroker&) = delete;
+
+    // The client end of a new connection, or -1. The caller owns it.
+    int connectPair();
+
+    // Accepts connections on 127.0.0.1:port; 0 picks a free port. Returns
+    // the port, or 0 on failure.
+    int listen(int port);
+
+    // Closes every connection and waits for their threads.
+    void stop();
+
+private:
+    struct Connection {
+        explicit Connection(int fd) : fd(fd), writeMutex(), outbound(), closing(false), queued(), reader() {}
+        int fd;
+        std::mutex writeMutex;
+        std::string outbound;  // frames with their NULs, not yet written
+        bool closing;          // no more frames are queued
+        std::condition_variable queued;
+        std::thread reader;
+    };
+
+    void send(int connectionId, const std::string& frame) override;
+    int addConnection(int fd);
+    void serve(int connectionId, Connection& connection);
+    void writeLoop(Connection& connection);
+    void acceptLoop();
+
+    BrokerCore core;
+    std::mutex connectionsMutex;
+    // Entries stay until stop(), so a Connection& never dangles.
+    std::map<int, std::unique_ptr<Connection>> connections;
+    int nextConnectionId;
+    int listenFd;
+    std::thread acceptor;
+    std::atomic<bool> stopping;
+};
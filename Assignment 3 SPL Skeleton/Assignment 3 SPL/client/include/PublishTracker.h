@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include "../include/GameIdCache.h"
+#include "../include/LatencyHistogram.h"
+
+// Receive-side accounting of MESSAGEs that carry publish headers: publish
+// to deliver latency per channel, and per (publisher, channel) stream the
+// sequence gaps and late arrivals.
+//
+// A sequence above the next expected one counts the skipped numbers as
+// missing; one at or below the highest seen counts as reordered and fills
+// one missing slot. A sequence of 1 after a higher one is a publisher that
+// logged in again and starts its stream over. Latency is only meaningful
+// when publisher and subscriber share a host, since publish-ts comes from
+// the publisher's monotonic clock.
+class PublishTracker {
+public:
+    PublishTracker();
+
+    void record(GameId game, const std::string& publisher, std::uint64_t sequence, std::uint64_t publishedAt,
+                std::uint64_t deliveredAt);
+    void clear();
+    bool empty() const;
+
+    // Writes the latency histograms and stream counters; channelName maps
+    // a game id to its display name.
+    template <typename ChannelName>
+    void report(std::ostream& out, ChannelName channelName) const;
+
+private:
+    struct Stream {
+        Stream() : highest(0), received(0), missing(0), reordered(0) {}
+        std::uint64_t highest;
+        std::uint64_t received;
+        std::uint64_t missing;
+        std::uint64_t reordered;
+    };
+
+    static void writeLatency(std::ostream& out, const std::string& label, const LatencyHistogram& histogram);
+
+    LatencyHistogram allChannels;
+    std::map<GameId, LatencyHistogram> byChannel;
+    std::map<std::pair<GameId, std::string>, Stream> streams;
+};
+
+template <typename ChannelName>
+void PublishTracker::report(std::ostream& out, ChannelName channelName) const {
+    out << "Publish latency (" << allChannels.count() << " stamped messages):" << std::endl;
+    if (allChannels.count() == 0) return;
+    writeLatency(out, "all channels", allChannels);
+    for (const auto& entry : byChannel) {
+        writeLatency(out, channelName(entry.first), entry.second);
+    }
+    out << "Publish streams:" << std::endl;
+    for (const auto& entry : streams) {
+        const Stream& stream = entry.second;
+        out << "  " << entry.first.second << " -> " << channelName(entry.first.first) << ": received "
+            << stream.received << ", missing " << stream.missing << ", reordered " << stream.reordered << std::endl;
+    }
+}
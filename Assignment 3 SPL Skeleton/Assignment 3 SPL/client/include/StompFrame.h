@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <cstring>
+#include "../include/event.h"
+
+// Non-owning view of a run of characters inside a frame.
+struct TextView {
+    TextView() : data(nullptr), size(0) {}
+    TextView(const char* data, std::size_t size) : data(data), size(size) {}
+
+    bool empty() const { return size == 0; }
+    bool equals(const char* literal) const {
+        std::size_t length = std::strlen(literal);
+        return size == length && std::memcmp(data, literal, length) == 0;
+    }
+    bool startsWith(const char* literal, std::size_t length) const {
+        return size >= length && std::memcmp(data, literal, length) == 0;
+    }
+    TextView substr(std::size_t pos) const { return pos >= size ? TextView() : TextView(data + pos, size - pos); }
+    TextView trimmed() const;
+    std::string str() const { return std::string(data, size); }
+
+    const char* data;
+    std::size_t size;
+};
+
+// Splits a received frame into command, header block and body without
+// copying. The frame must outlive the view.
+class FrameView {
+public:
+    explicit FrameView(const std::string& frame);
+
+    const TextView& command() const { return commandText; }
+    // Value of the first header with this name, or an empty view.
+    TextView header(const char* name) const;
+    // All header lines, '\n'-separated (see forEachLine).
+    const TextView& headers() const { return headerBlock; }
+    bool hasBody() const { return bodyFound; }
+    // Body without the trailing NUL, if any.
+    const TextView& body() const { return bodyText; }
+
+private:
+    TextView commandText;
+    TextView headerBlock;
+    TextView bodyText;
+    bool bodyFound;
+};
+
+// Calls visit(line) for each '\n'-separated line of text until it returns false.
+template <typename Visitor>
+void forEachLine(const TextView& text, Visitor visit) {
+    const char* pos = text.data;
+    const char* end = text.data + text.size;
+    while (pos < end) {
+        const char* newline = static_cast<const char*>(std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+        const char* lineEnd = newline == nullptr ? end : newline;
+        if (!visit(TextView(pos, static_cast<std::size_t>(lineEnd - pos)))) return;
+        pos = lineEnd + 1;
+    }
+}
+
+// Encoding of the frames the client builds from events.
+
+// Exact number of bytes appendReportFrame will append.
+std::size_t reportFrameSize(const std::string& destination, const std::string& user, const Event& event,
+                            std::uint64_t publishSequence = 0);
+
+// Appends the SEND frame reporting event as user to destination, including
+// the terminating NUL. A non-zero publishSequence adds the publish headers
+// (publisher, publish-seq and a zeroed publish-ts for stampPublishTime).
+void appendReportFrame(std::string& out, const std::string& destination, const std::string& user, const Event& event,
+                       std::uint64_t publishSequence = 0);
+
+// Fills in the publish-ts header of a frame built with a publishSequence,
+// in place. Returns false if the frame has no such header.
+bool stampPublishTime(std::string& frame, std::uint64_t nanos);
@@ -6,6 +6,16 @@
 #include <mutex>
 #include "../include/ConnectionHandler.h"
 #include "../include/event.h" 
+#include "../include/EventLog.h"
+#include "../include/EventSnapshot.h"
+#include "../include/WorkerPool.h"
+#include "../include/SubscriptionFilter.h"
+#include "../include/EventIndex.h"
+#include "../include/GameIdCache.h"
+#include "../include/Timeline.h"
+#include "../include/PublishTracker.h"
+#include "../include/StompFrame.h"
+#include "../include/ClientStats.h"
 
 class StompProtocol {
 private:
@@ -13,29 +23,70 @@ private:
     std::atomic<int> subscriptionCounter;
     std::atomic<int> receiptCounter;
     mutable std::mutex _mutex;
-    std::map<int, std::string> subIdToCanonical;
-    std::map<std::string, int> canonicalToSubId; 
+    std::map<int, GameId> subIdToGame;
+    std::map<GameId, int> gameToSubId;
     std::map<int, std::string> receiptIdToCommand;
-    std::map<std::string, std::string> canonicalToDestination;
-    std::map<std::string, std::map<std::string, std::vector<Event>>> gameReports;
-    static bool timelineHasRequiredEvents(const std::vector<Event>& events);
-    std::vector<Event> selectTimelineForSummary(const std::string& canonicalGame, const std::string& targetUser) const;
+    // When each pending receipt was requested, for the receipt round trip.
+    std::map<int, std::uint64_t> receiptSentAt;
+    GameIdCache gameIds;
+    std::map<GameId, std::string> gameDestinations;
+    std::map<GameId, SubscriptionFilter> subscriptionFilters;
+    std::map<GameId, std::map<std::string, Timeline>> gameReports;
+    EventIndex eventIndex;
+    EventLog eventLog;
+    bool eventLogEnabled;
+    EventSnapshot snapshot;
+    std::map<GameId, std::size_t> snapshotGames;
+    WorkerPool reportWorkers;
+    // "timestamps on": report SENDs carry publish headers, numbered per game.
+    bool publishTimestamps;
+    std::map<GameId, std::uint64_t> publishSequences;
+    PublishTracker publishTracker;
+    const Timeline* selectTimelineForSummary(GameId game, const std::string& targetUser) const;
     static std::string canonicalOwner(const Event& event);
-    static std::size_t eventDetailScore(const Event& event);
     bool shouldTerminate;
     static std::string trim(const std::string& value);
     static std::string normalizeGameName(const std::string& raw);
-    std::string resolveDestinationForCanonical(const std::string& canonical) const;
-    void ensureSummaryFile(std::ofstream& outFile, const std::string& teamA, const std::string& teamB,
-                           const std::vector<Event>& userEvents);
-    void storeEvent(const std::string& canonicalGame, const Event& event);
+    std::string resolveDestination(GameId game) const;
+    void storeEvent(GameId game, const Event& event);
+    // True if the event replaced one with the same time and name.
+    bool insertEvent(GameId game, const Event& event);
+    void materializeSnapshotGame(GameId game);
+    std::string processReport(const std::vector<std::string>& words);
+    void clearTimeline(GameId game, const std::string& owner);
+    void processQuery(const std::vector<std::string>& words);
+    void recordPublish(GameId game, const FrameView& view, const TextView& publishedAt, std::uint64_t receivedAt);
+    std::string processStats(const std::vector<std::string>& words);
+    std::string formatStats() const;
+    static std::string processTrace(const std::vector<std::string>& words);
+    // bench/MicroBench.cpp times storeEvent directly.
+    friend class ProtocolBenchAccess;
 
 public:
     StompProtocol();
     std::vector<std::string> split(const std::string& str, char delimiter);
     std::string processInput(std::string input);
-    void processResponse(std::string frame);
+    void processResponse(const std::string& frame);
+    // Starts the receipt round trip of a frame processInput returned, if it
+    // asks for a receipt. Called right before the frame is written, so time
+    // spent pacing or queueing does not count as server time.
+    void markFrameSent(const std::string& frame, std::uint64_t sentAt);
     bool isTerminated() const;
     void markConnectionClosed();
     void resetAfterSession();
+    // Replay the event log at path into gameReports and keep appending
+    // every stored event to it.
+    bool openEventLog(const std::string& path);
+    void closeEventLog();
+    // Map a snapshot written by saveSnapshot; games are turned back into
+    // Event objects the first time they are touched.
+    bool loadSnapshot(const std::string& path);
+    // Write the whole store as a snapshot and, if an event log is open,
+    // truncate it since the snapshot now covers its records.
+    bool saveSnapshot(const std::string& path);
+
+private:
+    // "stats dump": rewrites a file with formatStats() periodically. Last, so
+    // it is stopped before anything it reads is destroyed.
+    stats::PeriodicTask statsDump;
 };
\ No newline at end of file
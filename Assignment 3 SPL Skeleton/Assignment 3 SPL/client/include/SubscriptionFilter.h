@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../include/StompFrame.h"
+
+// Optional per-subscription predicate over MESSAGE bodies, given to join as
+//   owner=<user>[,<user>...]      report must come from one of these users
+//   event=<pattern>[,<pattern>...] event name must match one glob ('*', '?'),
+//                                  case-insensitively
+//   keys=<key>[,<key>...]          every key must appear in some update section
+// accepts() only looks at the body's leading lines and update keys, so a
+// rejected message is never turned into an Event.
+class SubscriptionFilter {
+public:
+    SubscriptionFilter();
+
+    // Parses the filter arguments; on failure returns false and sets error.
+    bool parse(const std::vector<std::string>& args, std::string& error);
+
+    bool empty() const;
+    bool accepts(const TextView& body) const;
+    std::string describe() const;
+
+private:
+    static bool globMatch(const char* pattern, std::size_t patternLength, const TextView& text);
+
+    std::vector<std::string> owners;
+    std::vector<std::string> eventPatterns;
+    std::vector<std::string> requiredKeys;
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../include/event.h"
+#include "../include/Timeline.h"
+
+// Summary file text for timeline; events are its events in report order
+// (time, then name). Stats come from the timeline's running tables, the
+// output size is computed first and the text is formatted into a single
+// buffer of exactly that size.
+std::string renderSummary(const std::string& teamA, const std::string& teamB, const Timeline& timeline,
+                          const std::vector<const Event*>& events);
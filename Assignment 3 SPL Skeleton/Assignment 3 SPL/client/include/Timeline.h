@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "../include/event.h"
+
+// Events a summary needs before it can be written. Each event is
+// classified once, by case-insensitive substring of its name.
+enum EventMilestone : unsigned {
+    MILESTONE_KICKOFF = 1u << 0,
+    MILESTONE_HALFTIME = 1u << 1,
+    MILESTONE_GOAL = 1u << 2,
+    MILESTONE_FINAL_WHISTLE = 1u << 3,
+    MILESTONES_REQUIRED = (1u << 4) - 1
+};
+
+unsigned classifyEventName(const std::string& name);
+std::size_t eventDetailScore(const Event& event);
+
+// The update maps of an event, in summary order.
+enum StatSection { STATS_GENERAL, STATS_TEAM_A, STATS_TEAM_B, STAT_SECTIONS };
+
+const std::map<std::string, std::string>& sectionUpdates(const Event& event, StatSection section);
+
+// The events one owner reported for one game, with the aggregates summary
+// selection needs. Mutate only through the methods so they stay in sync.
+//
+// milestones is a plain OR: events are only ever replaced by an event with
+// the same name (see StompProtocol::insertEvent) or cleared all at once.
+struct Timeline {
+    Timeline();
+
+    void append(const Event& event);
+    void replace(std::size_t position, const Event& event);
+    // Takes over events, e.g. a timeline materialized from a snapshot.
+    void adopt(std::vector<Event>& incoming);
+    void clear();
+
+    bool isComplete() const { return (milestones & MILESTONES_REQUIRED) == MILESTONES_REQUIRED; }
+
+    // Approximate heap bytes held by the events and stat tables (assumes
+    // libstdc++ node and short-string sizes).
+    std::size_t memoryUsage() const;
+
+    // Per section, stat key -> position of the event holding its latest
+    // value in report order (time, then name).
+    typedef std::map<std::string, std::size_t> StatTable;
+    const std::string& statValue(StatSection section, const StatTable::value_type& entry) const {
+        return sectionUpdates(events[entry.second], section).at(entry.first);
+    }
+
+    std::vector<Event> events;
+    unsigned milestones;
+    std::size_t detailScore;
+    StatTable stats[STAT_SECTIONS];
+
+private:
+    void noteStats(std::size_t position);
+    void recomputeStat(StatSection section, const std::string& key);
+};
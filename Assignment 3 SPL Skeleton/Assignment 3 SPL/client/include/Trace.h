@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Nanoseconds on the system-wide steady clock. The one time base of trace
+// spans, stats timers, publish-ts stamps and frame captures.
+std::uint64_t monotonicNanos();
+
+// Scoped spans of the client pipeline, written as Chrome trace JSON (open
+// it in ui.perfetto.dev or chrome://tracing). Each thread records into its
+// own ring buffer of the most recent spans. While tracing is off a Span is
+// a relaxed load and a branch.
+namespace trace {
+
+extern std::atomic<bool> active;
+
+inline bool enabled() {
+    return active.load(std::memory_order_relaxed);
+}
+
+// Clears every buffer and starts recording.
+void start();
+void stop();
+
+// name must outlive the trace, e.g. a string literal, and need no JSON escaping.
+void record(const char* name, std::uint64_t startNanos, std::uint64_t endNanos);
+
+// Labels the calling thread in the trace.
+void setThreadName(const std::string& name);
+
+struct Dump {
+    std::string json;
+    std::size_t spans;
+    // Spans overwritten because a ring buffer was full.
+    std::size_t dropped;
+};
+
+// Everything recorded since start(), with times relative to it.
+Dump render();
+
+class Span {
+public:
+    explicit Span(const char* name) : name(enabled() ? name : nullptr), startNanos(this->name ? monotonicNanos() : 0) {}
+    ~Span() {
+        if (name != nullptr) record(name, startNanos, monotonicNanos());
+    }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name;
+    std::uint64_t startNanos;
+};
+
+} // namespace trace
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run index-parallel jobs. The calling
+// thread takes part in every job, so a pool of N threads uses N + 1 cores.
+class WorkerPool {
+public:
+    // threads == 0 picks one less than the number of hardware threads.
+    explicit WorkerPool(std::size_t threads = 0);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls task(i) for every i in [0, count) and returns once all calls
+    // have finished. Only one job runs at a time.
+    void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    std::size_t size() const;
+
+private:
+    void workerLoop(std::size_t seen);
+    void drain();
+
+    std::size_t threadCount;
+    std::vector<std::thread> workers;
+    std::mutex runMutex;
+    std::mutex poolMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    const std::function<void(std::size_t)>* job;
+    std::size_t jobCount;
+    std::atomic<std::size_t> nextIndex;
+    std::size_t activeWorkers;
+    std::size_t generation;
+    bool stopping;
+};
@@ -38,4 +38,13 @@ struct names_and_events {
     std::vector<Event> events;
 };
 
-names_and_events parseEventsFile(std::string json_path);
\ No newline at end of file
+// How parseEventsFile gets the bytes to the JSON parser. Auto maps regular
+// files and falls back to streaming for pipes and other special files.
+enum class EventsFileReader {
+    Auto,
+    Stream,
+    Buffer,
+    Mmap
+};
+
+names_and_events parseEventsFile(std::string json_path, EventsFileReader reader = EventsFileReader::Auto);
\ No newline at end of file
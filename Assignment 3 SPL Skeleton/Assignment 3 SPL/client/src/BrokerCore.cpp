@@ -0,0 +1,193 @@
+#include "../include/BrokerCore.h"
+#include "../include/StompFrame.h"
+#include <cstring>
+
+namespace {
+
+const char MESSAGE_PREFIX[] = "MESSAGE\nsubscription:";
+
+std::string headerValue(const FrameView& view, const char* name) {
+    return view.header(name).trimmed().str();
+}
+
+// Headers the broker sets itself; every other SEND header is passed on to
+// the MESSAGEs (publish-ts / publish-seq, for instance).
+bool brokerHeader(const TextView& name) {
+    return name.equals("destination") || name.equals("receipt") || name.equals("subscription") ||
+           name.equals("message-id");
+}
+
+std::string forwardedHeaders(const FrameView& view) {
+    std::string forwarded;
+    forEachLine(view.headers(), [&](const TextView& line) {
+        const char* colon = static_cast<const char*>(std::memchr(line.data, ':', line.size));
+        if (colon == nullptr || colon == line.data) return true;
+        TextView name = TextView(line.data, static_cast<std::size_t>(colon - line.data)).trimmed();
+        if (brokerHeader(name)) return true;
+        TextView value = line.substr(static_cast<std::size_t>(colon - line.data) + 1).trimmed();
+        forwarded.append(name.data, name.size).append(1, ':').append(value.data, value.size).append(1, '\n');
+        return true;
+    });
+    return forwarded;
+}
+
+} // namespace
+
+BrokerCore::BrokerCore(BrokerOutput& output)
+    : output(output), stateMutex(), passwords(), activeUsers(), channels(), nextMessageId(0) {}
+
+bool BrokerCore::handle(Session& session, const std::string& frame) {
+    // A frame may follow stray newlines (heart-beats) on the wire.
+    std::size_t start = frame.find_first_not_of("\r\n");
+    if (start == std::string::npos) return true;
+    std::string trimmedFrame;
+    if (start > 0) trimmedFrame = frame.substr(start);
+    const std::string& text = start > 0 ? trimmedFrame : frame;
+
+    FrameView view(text);
+    TextView command = view.command().trimmed();
+    std::string receiptId = headerValue(view, "receipt");
+    if (command.empty()) return error(session, "malformed frame received", "", text);
+    if (!session.loggedIn && !command.equals("CONNECT")) return error(session, "Not connected", receiptId, text);
+
+    if (command.equals("CONNECT")) {
+        if (session.loggedIn) return error(session, "User already logged in", receiptId, text);
+        std::string login = headerValue(view, "login");
+        std::string passcode = headerValue(view, "passcode");
+        if (view.header("login").empty() || view.header("passcode").empty()) {
+            return error(session, "Missing login or passcode", receiptId, text);
+        }
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            auto known = passwords.emplace(login, passcode).first;
+            if (known->second != passcode) return error(session, "Wrong password", receiptId, text);
+            if (!activeUsers.emplace(login, session.connectionId).second) {
+                return error(session, "User already logged in", receiptId, text);
+            }
+        }
+        session.loggedIn = true;
+        session.username = login;
+        output.send(session.connectionId, "CONNECTED\nversion:1.2\n\n");
+        receipt(session, receiptId);
+        return true;
+    }
+
+    if (command.equals("SUBSCRIBE")) {
+        std::string destination = headerValue(view, "destination");
+        std::string id = headerValue(view, "id");
+        if (destination.empty() || id.empty()) return error(session, "Missing destination or id", receiptId, text);
+        if (session.destinationsById.count(id) != 0 || session.idsByDestination.count(destination) != 0) {
+            return error(session, "Subscription id already exists", receiptId, text);
+        }
+        session.destinationsById[id] = destination;
+        session.idsByDestination[destination] = id;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            std::shared_ptr<const SubscriberList>& current = channels[destination];
+            std::shared_ptr<SubscriberList> updated =
+                current ? std::make_shared<SubscriberList>(*current) : std::make_shared<SubscriberList>();
+            updated->push_back(Subscriber{session.connectionId, id});
+            current = updated;
+        }
+        receipt(session, receiptId);
+        return true;
+    }
+
+    if (command.equals("UNSUBSCRIBE")) {
+        std::string id = headerValue(view, "id");
+        if (id.empty()) return error(session, "Missing id", receiptId, text);
+        auto it = session.destinationsById.find(id);
+        if (it == session.destinationsById.end()) return error(session, "Subscription ID not found", receiptId, text);
+        std::string destination = it->second;
+        session.destinationsById.erase(it);
+        session.idsByDestination.erase(destination);
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            removeSubscriber(destination, session.connectionId);
+        }
+        receipt(session, receiptId);
+        return true;
+    }
+
+    if (command.equals("SEND")) {
+        std::string destination = headerValue(view, "destination");
+        if (destination.empty()) return error(session, "Missing destination", receiptId, text);
+        if (session.idsByDestination.count(destination) == 0) {
+            return error(session, "User not subscribed to topic", receiptId, text);
+        }
+        std::shared_ptr<const SubscriberList> subscribers;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            auto channel = channels.find(destination);
+            if (channel != channels.end()) subscribers = channel->second;
+        }
+        // Everything after the subscription header is the same for every subscriber.
+        std::string shared = "\ndestination:" + destination + "\nmessage-id:" + std::to_string(++nextMessageId) +
+                             "\n" + forwardedHeaders(view) + "\n";
+        shared.append(view.body().data, view.body().size);
+        std::string message;
+        if (subscribers) {
+            for (const Subscriber& subscriber : *subscribers) {
+                message.clear();
+                message.reserve(sizeof(MESSAGE_PREFIX) + subscriber.subscriptionId.size() + shared.size());
+                message.append(MESSAGE_PREFIX).append(subscriber.subscriptionId).append(shared);
+                output.send(subscriber.connectionId, message);
+            }
+        }
+        receipt(session, receiptId);
+        return true;
+    }
+
+    if (command.equals("DISCONNECT")) {
+        if (receiptId.empty()) return error(session, "DISCONNECT must include receipt header", "", text);
+        close(session);
+        receipt(session, receiptId);
+        return false;
+    }
+
+    return error(session, "Unknown command", receiptId, text);
+}
+
+void BrokerCore::close(Session& session) {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    for (const auto& subscription : session.idsByDestination) {
+        removeSubscriber(subscription.first, session.connectionId);
+    }
+    session.destinationsById.clear();
+    session.idsByDestination.clear();
+    if (session.loggedIn) {
+        auto active = activeUsers.find(session.username);
+        if (active != activeUsers.end() && active->second == session.connectionId) activeUsers.erase(active);
+    }
+    session.loggedIn = false;
+    session.username.clear();
+}
+
+bool BrokerCore::error(Session& session, const std::string& message, const std::string& receiptId,
+                       const std::string& frame) {
+    std::string text = "ERROR\nmessage:" + message + "\n";
+    if (!receiptId.empty()) text += "receipt-id:" + receiptId + "\n";
+    text += "\nThe message:\n-----\n";
+    text.append(frame.c_str());
+    text += "\n-----\n";
+    output.send(session.connectionId, text);
+    return false;
+}
+
+void BrokerCore::receipt(Session& session, const std::string& receiptId) {
+    if (!receiptId.empty()) output.send(session.connectionId, "RECEIPT\nreceipt-id:" + receiptId + "\n\n");
+}
+
+void BrokerCore::removeSubscriber(const std::string& destination, int connectionId) {
+    auto channel = channels.find(destination);
+    if (channel == channels.end()) return;
+    std::shared_ptr<SubscriberList> updated = std::make_shared<SubscriberList>();
+    for (const Subscriber& subscriber : *channel->second) {
+        if (subscriber.connectionId != connectionId) updated->push_back(subscriber);
+    }
+    if (updated->empty()) {
+        channels.erase(channel);
+    } else {
+        channel->second = updated;
+    }
+}
@@ -0,0 +1,130 @@
+#include "../include/ClientStats.h"
+#include <memory>
+#include <vector>
+
+namespace stats {
+
+namespace {
+
+const std::size_t VALUE_COUNT = COUNTER_COUNT + 3 * TIMER_COUNT;
+
+struct ThreadSlot {
+    ThreadSlot() {
+        for (std::atomic<std::uint64_t>& value : values) value.store(0, std::memory_order_relaxed);
+    }
+    std::atomic<std::uint64_t> values[VALUE_COUNT];
+};
+
+// Slots are never freed, so a reader can sum them after their thread exits.
+struct Registry {
+    Registry() : registryMutex(), slots() {}
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadSlot>> slots;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+thread_local ThreadSlot* localSlot = nullptr;
+
+ThreadSlot& slot() {
+    if (localSlot == nullptr) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.registryMutex);
+        shared.slots.emplace_back(new ThreadSlot());
+        localSlot = shared.slots.back().get();
+    }
+    return *localSlot;
+}
+
+void add(std::size_t index, std::uint64_t amount) {
+    std::atomic<std::uint64_t>& value = slot().values[index];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+std::atomic<std::uint64_t> sendQueueDepth(0);
+std::atomic<std::uint64_t> sendQueueDepthMax(0);
+
+} // namespace
+
+void count(Counter counter, std::uint64_t amount) {
+    add(counter, amount);
+}
+
+void recordTime(Timer timer, std::uint64_t nanos) {
+    std::size_t base = COUNTER_COUNT + 3 * static_cast<std::size_t>(timer);
+    add(base, 1);
+    add(base + 1, nanos);
+    std::atomic<std::uint64_t>& max = slot().values[base + 2];
+    if (nanos > max.load(std::memory_order_relaxed)) max.store(nanos, std::memory_order_relaxed);
+}
+
+void setSendQueueDepth(std::uint64_t depth) {
+    sendQueueDepth.store(depth, std::memory_order_relaxed);
+    if (depth > sendQueueDepthMax.load(std::memory_order_relaxed)) {
+        sendQueueDepthMax.store(depth, std::memory_order_relaxed);
+    }
+}
+
+Snapshot read() {
+    Snapshot snapshot = {};
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.registryMutex);
+    for (const std::unique_ptr<ThreadSlot>& threadSlot : shared.slots) {
+        const std::atomic<std::uint64_t>* values = threadSlot->values;
+        for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+            snapshot.counters[i] += values[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t t = 0; t < TIMER_COUNT; ++t) {
+            std::size_t base = COUNTER_COUNT + 3 * t;
+            TimerTotals& totals = snapshot.timers[t];
+            totals.count += values[base].load(std::memory_order_relaxed);
+            totals.totalNanos += values[base + 1].load(std::memory_order_relaxed);
+            std::uint64_t max = values[base + 2].load(std::memory_order_relaxed);
+            if (max > totals.maxNanos) totals.maxNanos = max;
+        }
+    }
+    snapshot.sendQueueDepth = sendQueueDepth.load(std::memory_order_relaxed);
+    snapshot.sendQueueDepthMax = sendQueueDepthMax.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+PeriodicTask::PeriodicTask() : worker(), taskMutex(), wake(), stopping(false) {}
+
+PeriodicTask::~PeriodicTask() {
+    stop();
+}
+
+void PeriodicTask::start(std::chrono::milliseconds interval, const std::function<void()>& task) {
+    stop();
+    std::lock_guard<std::mutex> lock(taskMutex);
+    stopping = false;
+    worker = std::thread(&PeriodicTask::loop, this, interval, task);
+}
+
+void PeriodicTask::stop() {
+    {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+bool PeriodicTask::running() const {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    return worker.joinable() && !stopping;
+}
+
+void PeriodicTask::loop(std::chrono::milliseconds interval, std::function<void()> task) {
+    std::unique_lock<std::mutex> lock(taskMutex);
+    while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+} // namespace stats
@@ -1,4 +1,9 @@
 #include "ConnectionHandler.h"
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <sys/socket.h>
 
 using boost::asio::ip::tcp;
 
@@ -8,8 +13,13 @@ using std::cerr;
 using std::endl;
 using std::string;
 
+namespace {
+const std::size_t READ_BUFFER_SIZE = 64 * 1024;
+}
+
 ConnectionHandler::ConnectionHandler(string host, short port) : 
-    host_(host), port_(port), io_service_(), socket_(io_service_) {}
+    host_(host), port_(port), io_service_(), socket_(io_service_),
+    readBuffer_(READ_BUFFER_SIZE), readStart_(0), readEnd_(0), capture_(nullptr) {}
 
 ConnectionHandler::~ConnectionHandler() {
     close();
@@ -22,6 +32,9 @@ bool ConnectionHandler::connect() {
         socket_.connect(endpoint, error);
         if (error)
             throw boost::system::system_error(error);
+        // Frames are small and usually wait for a reply; Nagle would hold
+        // each one back until the previous one is acknowledged.
+        socket_.set_option(tcp::no_delay(true), error);
     }
     catch (std::exception &e) {
         cerr << "Connection failed (Error: " << e.what() << ')' << endl;
@@ -30,8 +43,42 @@ bool ConnectionHandler::connect() {
     return true;
 }
 
+bool ConnectionHandler::adopt(int fd) {
+    // socket_ is a tcp::socket, so its protocol must match the descriptor's
+    // or option and endpoint calls on it fail or misreport.
+    sockaddr_storage local;
+    socklen_t length = sizeof(local);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&local), &length) != 0 ||
+        (local.ss_family != AF_INET && local.ss_family != AF_INET6)) {
+        cerr << "Adopting socket failed (Error: not a TCP socket)" << endl;
+        return false;
+    }
+    boost::system::error_code error;
+    socket_.assign(local.ss_family == AF_INET ? tcp::v4() : tcp::v6(), fd, error);
+    if (error) {
+        cerr << "Adopting socket failed (Error: " << error.message() << ')' << endl;
+        return false;
+    }
+    socket_.set_option(tcp::no_delay(true), error);
+    return true;
+}
+
+bool ConnectionHandler::fillReadBuffer() {
+    boost::system::error_code error;
+    size_t received = socket_.read_some(boost::asio::buffer(readBuffer_.data(), readBuffer_.size()), error);
+    if (error) {
+        cerr << "recv failed (Error: " << error.message() << ')' << endl;
+        return false;
+    }
+    readStart_ = 0;
+    readEnd_ = received;
+    return true;
+}
+
 bool ConnectionHandler::getBytes(char bytes[], unsigned int bytesToRead) {
-    size_t tmp = 0;
+    size_t tmp = std::min<size_t>(bytesToRead, readEnd_ - readStart_);
+    std::memcpy(bytes, readBuffer_.data() + readStart_, tmp);
+    readStart_ += tmp;
     boost::system::error_code error;
     try {
         while (!error && bytesToRead > tmp) {
@@ -72,28 +119,45 @@ bool ConnectionHandler::sendLine(std::string &line) {
     return sendFrameAscii(line, '\n');
 }
 
+// Scans the receive buffer for the delimiter and refills it with one
+// read_some per chunk rather than one syscall per byte.
 bool ConnectionHandler::getFrameAscii(std::string &frame, char delimiter) {
-    char ch;
-    try {
-        do {
-            if (!getBytes(&ch, 1)) {
-                return false;
-            }
-            if (ch != delimiter)
-                frame.append(1, ch);
-        } while (delimiter != ch);
-    }
-    catch (std::exception &e) {
-        cerr << "recv failed (Error: " << e.what() << ')' << endl;
-        return false;
+    while (true) {
+        if (readStart_ == readEnd_ && !fillReadBuffer()) {
+            return false;
+        }
+        const char* begin = readBuffer_.data() + readStart_;
+        size_t available = readEnd_ - readStart_;
+        const char* found = static_cast<const char*>(std::memchr(begin, delimiter, available));
+        if (found != nullptr) {
+            size_t length = static_cast<size_t>(found - begin);
+            frame.append(begin, length);
+            readStart_ += length + 1;
+            if (capture_ != nullptr) capture_->record(frame);
+            return true;
+        }
+        frame.append(begin, available);
+        readStart_ = readEnd_;
     }
-    return true;
+}
+
+void ConnectionHandler::setCapture(FrameCaptureWriter* capture) {
+    capture_ = capture;
 }
 
 bool ConnectionHandler::sendFrameAscii(const std::string &frame, char delimiter) {
-    bool result = sendBytes(frame.c_str(), frame.length());
-    if (!result) return false;
-    return sendBytes(&delimiter, 1);
+    trace::Span span("sendFrameAscii");
+    // Frame and delimiter go out in one gathered write, never as a second
+    // 1-byte segment.
+    std::array<boost::asio::const_buffer, 2> buffers = {{
+        boost::asio::buffer(frame.data(), frame.length()), boost::asio::buffer(&delimiter, 1)}};
+    boost::system::error_code error;
+    boost::asio::write(socket_, buffers, error);
+    if (error) {
+        cerr << "send failed (Error: " << error.message() << ')' << endl;
+        return false;
+    }
+    return true;
 }
 
 void ConnectionHandler::close() {
@@ -0,0 +1,308 @@
+#include "../include/EpollBroker.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const std::size_t READ_CHUNK = 64 * 1024;
+const int MAX_EVENTS = 256;
+// epoll tags of the two descriptors that are not connections.
+const std::uint64_t LISTENER_TAG = ~0ull;
+const std::uint64_t WAKE_TAG = ~0ull - 1;
+
+bool watch(int epollFd, int fd, std::uint32_t events, std::uint64_t tag) {
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = tag;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void closeFd(int& fd) {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+} // namespace
+
+struct EpollBroker::Connection {
+    Connection(int fd, int id)
+        : fd(fd), session(id), inbound(), closing(false), writeMutex(), outbound(), sent(0) {}
+
+    // Writes as much of outbound as the socket takes. False on a socket
+    // error. Caller holds writeMutex.
+    bool flush() {
+        while (sent < outbound.size()) {
+            ssize_t written = ::send(fd, outbound.data() + sent, outbound.size() - sent, MSG_NOSIGNAL);
+            if (written > 0) {
+                sent += static_cast<std::size_t>(written);
+            } else if (written < 0 && errno == EINTR) {
+                continue;
+            } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (sent >= READ_CHUNK) {
+                    outbound.erase(0, sent);
+                    sent = 0;
+                }
+                return true;
+            } else {
+                return false;
+            }
+        }
+        outbound.clear();
+        sent = 0;
+        return true;
+    }
+
+    // Changed only by the owning reactor, under writeMutex; -1 once closed.
+    int fd;
+    // The rest of this group is used by the owning reactor only.
+    BrokerCore::Session session;
+    std::string inbound;  // bytes of a frame whose NUL has not arrived
+    bool closing;         // no more frames; close once outbound is written
+
+    std::mutex writeMutex;
+    std::string outbound;  // frames with their NULs, not yet written
+    std::size_t sent;      // bytes of outbound already written
+};
+
+struct EpollBroker::Reactor {
+    explicit Reactor(int index)
+        : index(index), epollFd(-1), listenFd(-1), wakeFd(-1), thread(), connectionsMutex(), connections(),
+          nextSequence(0), readBuffer(READ_CHUNK), frame() {}
+
+    int index;
+    int epollFd;
+    int listenFd;
+    int wakeFd;
+    std::thread thread;
+    // Changed only by this reactor's thread; others look up fan-out targets
+    // under the lock.
+    std::mutex connectionsMutex;
+    std::map<int, std::shared_ptr<Connection>> connections;
+    int nextSequence;
+    std::vector<char> readBuffer;
+    std::string frame;  // reused for every complete frame
+};
+
+EpollBroker::EpollBroker(int threads) : core(*this), reactors() {
+    for (int i = 0; i < (threads > 0 ? threads : 1); ++i) reactors.emplace_back(new Reactor(i));
+}
+
+EpollBroker::~EpollBroker() {
+    stop();
+}
+
+int EpollBroker::start(int port) {
+    for (auto& reactor : reactors) {
+        if (!listenOn(*reactor, port)) {
+            stop();
+            return 0;
+        }
+    }
+    for (auto& reactor : reactors) reactor->thread = std::thread(&EpollBroker::run, this, std::ref(*reactor));
+    return port;
+}
+
+bool EpollBroker::listenOn(Reactor& reactor, int& port) {
+    reactor.listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (reactor.listenFd < 0) return false;
+    int on = 1;
+    setsockopt(reactor.listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (setsockopt(reactor.listenFd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) return false;
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    socklen_t length = sizeof(address);
+    if (::bind(reactor.listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(reactor.listenFd, SOMAXCONN) != 0 ||
+        getsockname(reactor.listenFd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        return false;
+    }
+    // With port 0 the first listener picks it and the others share it.
+    port = ntohs(address.sin_port);
+
+    reactor.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    reactor.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return reactor.epollFd >= 0 && reactor.wakeFd >= 0 &&
+           watch(reactor.epollFd, reactor.listenFd, EPOLLIN | EPOLLET, LISTENER_TAG) &&
+           watch(reactor.epollFd, reactor.wakeFd, EPOLLIN, WAKE_TAG);
+}
+
+void EpollBroker::stop() {
+    for (auto& reactor : reactors) {
+        std::uint64_t one = 1;
+        if (reactor->wakeFd >= 0 && ::write(reactor->wakeFd, &one, sizeof(one)) < 0) {
+            // The reactor is already stopping.
+        }
+    }
+    for (auto& reactor : reactors) {
+        if (reactor->thread.joinable()) reactor->thread.join();
+    }
+    for (auto& reactor : reactors) {
+        std::map<int, std::shared_ptr<Connection>> closing;
+        {
+            std::lock_guard<std::mutex> lock(reactor->connectionsMutex);
+            closing.swap(reactor->connections);
+        }
+        for (auto& entry : closing) {
+            core.close(entry.second->session);
+            std::lock_guard<std::mutex> lock(entry.second->writeMutex);
+            closeFd(entry.second->fd);
+        }
+        closeFd(reactor->listenFd);
+        closeFd(reactor->wakeFd);
+        closeFd(reactor->epollFd);
+    }
+}
+
+void EpollBroker::send(int connectionId, const std::string& frame) {
+    Reactor& reactor = *reactors[static_cast<std::size_t>(connectionId - 1) % reactors.size()];
+    std::shared_ptr<Connection> connection;
+    {
+        std::lock_guard<std::mutex> lock(reactor.connectionsMutex);
+        auto found = reactor.connections.find(connectionId);
+        if (found != reactor.connections.end()) connection = found->second;
+    }
+    if (!connection) return;
+
+    std::lock_guard<std::mutex> lock(connection->writeMutex);
+    if (connection->fd < 0) return;
+    // Bytes already queued mean the socket was full; the owner's EPOLLOUT
+    // edge flushes them together with this frame.
+    bool idle = connection->outbound.empty();
+    connection->outbound.append(frame).push_back('\0');
+    if (idle && !connection->flush()) ::shutdown(connection->fd, SHUT_RDWR);
+}
+
+void EpollBroker::run(Reactor& reactor) {
+    epoll_event events[MAX_EVENTS];
+    while (true) {
+        int ready = epoll_wait(reactor.epollFd, events, MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < ready; ++i) {
+            std::uint64_t tag = events[i].data.u64;
+            if (tag == WAKE_TAG) return;
+            if (tag == LISTENER_TAG) {
+                acceptAll(reactor);
+                continue;
+            }
+            auto found = reactor.connections.find(static_cast<int>(tag));
+            if (found == reactor.connections.end()) continue;  // closed earlier in this batch
+            std::shared_ptr<Connection> connection = found->second;
+            std::uint32_t flags = events[i].events;
+
+            if (flags & EPOLLOUT) {
+                bool done;
+                {
+                    std::lock_guard<std::mutex> lock(connection->writeMutex);
+                    done = !connection->flush() || (connection->closing && connection->outbound.empty());
+                }
+                if (done) {
+                    closeConnection(reactor, connection);
+                    continue;
+                }
+            }
+            // Hang-ups and errors surface as a failed or empty read.
+            if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) readAll(reactor, connection);
+        }
+    }
+}
+
+void EpollBroker::acceptAll(Reactor& reactor) {
+    while (true) {
+        int fd = ::accept4(reactor.listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        // The id says which reactor owns the connection, see send().
+        int id = reactor.nextSequence++ * static_cast<int>(reactors.size()) + reactor.index + 1;
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd, id);
+        {
+            std::lock_guard<std::mutex> lock(reactor.connectionsMutex);
+            reactor.connections[id] = connection;
+        }
+        if (!watch(reactor.epollFd, fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, static_cast<std::uint64_t>(id))) {
+            closeConnection(reactor, connection);
+        }
+    }
+}
+
+void EpollBroker::readAll(Reactor& reactor, const std::shared_ptr<Connection>& connection) {
+    // Edge-triggered: read until the socket is empty or the next edge never comes.
+    while (true) {
+        ssize_t received = ::recv(connection->fd, reactor.readBuffer.data(), reactor.readBuffer.size(), 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (received <= 0) {
+            closeConnection(reactor, connection);
+            return;
+        }
+        if (connection->closing) continue;
+
+        const char* pos = reactor.readBuffer.data();
+        const char* end = pos + received;
+        while (pos < end) {
+            const char* nul = static_cast<const char*>(std::memchr(pos, '\0', static_cast<std::size_t>(end - pos)));
+            if (nul == nullptr) {
+                connection->inbound.append(pos, end);
+                break;
+            }
+            if (connection->inbound.empty()) {
+                reactor.frame.assign(pos, nul);
+            } else {
+                connection->inbound.append(pos, nul);
+                reactor.frame.swap(connection->inbound);
+                connection->inbound.clear();
+            }
+            pos = nul + 1;
+            if (!core.handle(connection->session, reactor.frame)) {
+                if (finish(reactor, connection)) return;
+                break;
+            }
+        }
+    }
+}
+
+bool EpollBroker::finish(Reactor& reactor, const std::shared_ptr<Connection>& connection) {
+    connection->closing = true;
+    connection->inbound.clear();
+    bool written;
+    {
+        std::lock_guard<std::mutex> lock(connection->writeMutex);
+        written = connection->outbound.empty();
+    }
+    if (written) closeConnection(reactor, connection);
+    return written;
+}
+
+void EpollBroker::closeConnection(Reactor& reactor, const std::shared_ptr<Connection>& connection) {
+    core.close(connection->session);
+    {
+        std::lock_guard<std::mutex> lock(reactor.connectionsMutex);
+        reactor.connections.erase(connection->session.id());
+    }
+    // Closing also removes it from the epoll set.
+    std::lock_guard<std::mutex> lock(connection->writeMutex);
+    closeFd(connection->fd);
+}
@@ -0,0 +1,161 @@
+#include "../include/EventIndex.h"
+#include <cctype>
+
+namespace {
+
+const std::size_t MIN_COMPACTION_SLOTS = 4096;
+const std::uint32_t NO_SLOT = 0xffffffffu;
+
+} // namespace
+
+EventIndex::EventIndex() :
+    slots(), retiredSlots(0), nameIndex(), statIndex(), timeIndex(), timelineSlots() {}
+
+std::vector<std::string> EventIndex::nameTokens(const std::string& name) {
+    std::vector<std::string> tokens;
+    std::string current;
+    for (char c : name) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc)) {
+            current.push_back(static_cast<char>(std::tolower(uc)));
+        } else if (!current.empty()) {
+            tokens.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty()) tokens.push_back(current);
+    return tokens;
+}
+
+std::uint32_t EventIndex::newSlot(const Entry& entry) {
+    std::uint32_t slot = static_cast<std::uint32_t>(slots.size());
+    slots.push_back(entry);
+    indexSlot(slot);
+    return slot;
+}
+
+void EventIndex::indexSlot(std::uint32_t slot) {
+    const Event& event = slots[slot].event();
+
+    std::vector<std::string> tokens = nameTokens(event.get_name());
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        bool repeated = false;
+        for (std::size_t j = 0; j < i; ++j) repeated = repeated || tokens[j] == tokens[i];
+        if (!repeated) nameIndex[tokens[i]].push_back(slot);
+    }
+
+    const std::map<std::string, std::string>* sections[] = {
+        &event.get_game_updates(), &event.get_team_a_updates(), &event.get_team_b_updates()};
+    for (std::size_t i = 0; i < 3; ++i) {
+        for (const auto& update : *sections[i]) {
+            bool repeated = false;
+            for (std::size_t j = 0; j < i; ++j) repeated = repeated || sections[j]->count(update.first) != 0;
+            if (!repeated) statIndex[update.first].push_back(slot);
+        }
+    }
+
+    timeIndex.emplace(event.get_time(), slot);
+}
+
+void EventIndex::add(const std::string& game, const std::string& owner, const std::vector<Event>& timeline,
+                     std::size_t position) {
+    Entry entry = {&game, &owner, &timeline, static_cast<std::uint32_t>(position), true};
+    std::vector<std::uint32_t>& positions = timelineSlots[&timeline];
+    if (positions.size() <= position) positions.resize(position + 1, NO_SLOT);
+    positions[position] = newSlot(entry);
+}
+
+void EventIndex::replace(const std::vector<Event>& timeline, std::size_t position) {
+    auto it = timelineSlots.find(&timeline);
+    if (it == timelineSlots.end() || position >= it->second.size() || it->second[position] == NO_SLOT) return;
+
+    Entry entry = slots[it->second[position]];
+    retire(it->second[position]);
+    it->second[position] = newSlot(entry);
+    compactIfNeeded();
+}
+
+void EventIndex::removeTimeline(const std::vector<Event>& timeline) {
+    auto it = timelineSlots.find(&timeline);
+    if (it == timelineSlots.end()) return;
+    for (std::uint32_t slot : it->second) {
+        if (slot != NO_SLOT) retire(slot);
+    }
+    timelineSlots.erase(it);
+    compactIfNeeded();
+}
+
+void EventIndex::retire(std::uint32_t slot) {
+    if (!slots[slot].live) return;
+    slots[slot].live = false;
+    ++retiredSlots;
+}
+
+void EventIndex::compactIfNeeded() {
+    if (retiredSlots < MIN_COMPACTION_SLOTS || retiredSlots * 2 < slots.size()) return;
+
+    std::vector<Entry> live;
+    live.reserve(slots.size() - retiredSlots);
+    for (const Entry& entry : slots) {
+        if (entry.live) live.push_back(entry);
+    }
+
+    slots.clear();
+    retiredSlots = 0;
+    nameIndex.clear();
+    statIndex.clear();
+    timeIndex.clear();
+    for (auto& positions : timelineSlots) {
+        positions.second.assign(positions.second.size(), NO_SLOT);
+    }
+    for (const Entry& entry : live) {
+        timelineSlots[entry.timeline][entry.position] = newSlot(entry);
+    }
+}
+
+void EventIndex::collect(const std::vector<std::uint32_t>& postings, std::vector<const Entry*>& out) const {
+    for (std::uint32_t slot : postings) {
+        if (slots[slot].live) out.push_back(&slots[slot]);
+    }
+}
+
+std::vector<const EventIndex::Entry*> EventIndex::byNameToken(const std::string& token, bool prefix) const {
+    std::vector<const Entry*> results;
+    if (!prefix) {
+        auto it = nameIndex.find(token);
+        if (it != nameIndex.end()) collect(it->second, results);
+        return results;
+    }
+
+    // Prefix matches can reach one event through several tokens.
+    std::vector<bool> seen;
+    for (auto it = nameIndex.lower_bound(token); it != nameIndex.end() && it->first.compare(0, token.size(), token) == 0; ++it) {
+        for (std::uint32_t slot : it->second) {
+            if (!slots[slot].live) continue;
+            if (seen.empty()) seen.assign(slots.size(), false);
+            if (seen[slot]) continue;
+            seen[slot] = true;
+            results.push_back(&slots[slot]);
+        }
+    }
+    return results;
+}
+
+std::vector<const EventIndex::Entry*> EventIndex::byStatKey(const std::string& key) const {
+    std::vector<const Entry*> results;
+    auto it = statIndex.find(key);
+    if (it != statIndex.end()) collect(it->second, results);
+    return results;
+}
+
+std::vector<const EventIndex::Entry*> EventIndex::byTimeRange(int from, int to) const {
+    std::vector<const Entry*> results;
+    for (auto it = timeIndex.lower_bound(from); it != timeIndex.end() && it->first <= to; ++it) {
+        if (slots[it->second].live) results.push_back(&slots[it->second]);
+    }
+    return results;
+}
+
+std::size_t EventIndex::size() const {
+    return slots.size() - retiredSlots;
+}
@@ -0,0 +1,377 @@
+#include "../include/EventLog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char LOG_MAGIC[8] = {'S', 'T', 'O', 'M', 'P', 'L', 'G', '1'};
+const std::size_t RECORD_HEADER_SIZE = 8;
+
+std::uint32_t fnv1a(const char* data, std::size_t len) {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putU32(std::string& out, std::uint32_t value) {
+    char bytes[4];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    out.append(bytes, sizeof(bytes));
+}
+
+void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<std::uint32_t>(value.size()));
+    out.append(value);
+}
+
+void putMap(std::string& out, const std::map<std::string, std::string>& values) {
+    putU32(out, static_cast<std::uint32_t>(values.size()));
+    for (const auto& entry : values) {
+        putString(out, entry.first);
+        putString(out, entry.second);
+    }
+}
+
+// Wraps a payload with its length and checksum header.
+std::string sealRecord(const std::string& payload) {
+    std::string record;
+    record.reserve(RECORD_HEADER_SIZE + payload.size());
+    putU32(record, static_cast<std::uint32_t>(payload.size()));
+    putU32(record, fnv1a(payload.data(), payload.size()));
+    record.append(payload);
+    return record;
+}
+
+class RecordReader {
+public:
+    RecordReader(const char* data, std::size_t len) : data(data), len(len), pos(0) {}
+
+    bool u8(std::uint8_t& value) {
+        if (len - pos < 1) return false;
+        value = static_cast<std::uint8_t>(data[pos++]);
+        return true;
+    }
+
+    bool u32(std::uint32_t& value) {
+        if (len - pos < 4) return false;
+        std::memcpy(&value, data + pos, 4);
+        pos += 4;
+        return true;
+    }
+
+    bool str(std::string& value) {
+        std::uint32_t size = 0;
+        if (!u32(size) || len - pos < size) return false;
+        value.assign(data + pos, size);
+        pos += size;
+        return true;
+    }
+
+    bool map(std::map<std::string, std::string>& values) {
+        std::uint32_t count = 0;
+        if (!u32(count)) return false;
+        std::string key;
+        std::string val;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (!str(key) || !str(val)) return false;
+            values.emplace_hint(values.end(), key, val);
+        }
+        return true;
+    }
+
+    bool done() const { return pos == len; }
+
+private:
+    const char* data;
+    std::size_t len;
+    std::size_t pos;
+};
+
+bool readWholeFile(int fd, std::string& out) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return false;
+    out.resize(static_cast<std::size_t>(st.st_size));
+    std::size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = ::read(fd, &out[done], out.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) break;
+        done += static_cast<std::size_t>(n);
+    }
+    out.resize(done);
+    return true;
+}
+
+bool writeAll(int fd, const char* data, std::size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        data += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool dispatchRecord(const char* payload, std::size_t len, const EventLog::ReplayHandler& handler,
+                    std::size_t& events) {
+    RecordReader reader(payload, len);
+    std::uint8_t type = 0;
+    std::string game;
+    if (!reader.u8(type) || !reader.str(game)) return false;
+
+    if (type == EventLog::RECORD_CLEAR_TIMELINE) {
+        std::string owner;
+        if (!reader.str(owner) || !reader.done()) return false;
+        if (handler.onClearTimeline) handler.onClearTimeline(game, owner);
+        return true;
+    }
+    if (type != EventLog::RECORD_EVENT) return false;
+
+    std::string owner, teamA, teamB, name, description;
+    std::uint32_t time = 0;
+    std::map<std::string, std::string> gameUpdates, teamAUpdates, teamBUpdates;
+    if (!reader.str(owner) || !reader.str(teamA) || !reader.str(teamB) || !reader.str(name) ||
+        !reader.u32(time) || !reader.map(gameUpdates) || !reader.map(teamAUpdates) ||
+        !reader.map(teamBUpdates) || !reader.str(description) || !reader.done()) {
+        return false;
+    }
+
+    Event event(teamA, teamB, name, static_cast<int>(time), gameUpdates, teamAUpdates, teamBUpdates, description);
+    event.set_event_owner(owner);
+    if (handler.onEvent) handler.onEvent(game, event);
+    ++events;
+    return true;
+}
+
+} // namespace
+
+EventLog::EventLog() :
+    fd(-1),
+    pending(),
+    queuedSeq(0),
+    committedSeq(0),
+    stopping(false),
+    writeFailed(false),
+    logMutex(),
+    workAvailable(),
+    batchCommitted(),
+    writer() {}
+
+EventLog::~EventLog() {
+    close();
+}
+
+EventLog::ReplayResult EventLog::replay(const std::string& path, const ReplayHandler& handler) {
+    ReplayResult result = {0, 0, 0, 0, false, false};
+    int readFd = ::open(path.c_str(), O_RDONLY);
+    if (readFd < 0) return result;
+
+    std::string contents;
+    bool readOk = readWholeFile(readFd, contents);
+    ::close(readFd);
+    if (!readOk) {
+        result.damaged = true;
+        return result;
+    }
+    // A file shorter than the magic is a log whose creation was torn.
+    std::size_t magicBytes = std::min(contents.size(), sizeof(LOG_MAGIC));
+    if (std::memcmp(contents.data(), LOG_MAGIC, magicBytes) != 0) {
+        result.unreadBytes = contents.size();
+        result.damaged = true;
+        return result;
+    }
+    if (contents.size() < sizeof(LOG_MAGIC)) {
+        result.unreadBytes = contents.size();
+        result.truncatedTail = !contents.empty();
+        return result;
+    }
+
+    std::size_t pos = sizeof(LOG_MAGIC);
+    const char* data = contents.data();
+    while (pos < contents.size()) {
+        std::size_t left = contents.size() - pos;
+        std::uint32_t length = 0;
+        std::uint32_t checksum = 0;
+        if (left >= RECORD_HEADER_SIZE) {
+            std::memcpy(&length, data + pos, 4);
+            std::memcpy(&checksum, data + pos + 4, 4);
+        }
+        if (left < RECORD_HEADER_SIZE || left - RECORD_HEADER_SIZE < length) {
+            result.truncatedTail = true;
+            break;
+        }
+
+        const char* payload = data + pos + RECORD_HEADER_SIZE;
+        if (fnv1a(payload, length) != checksum || !dispatchRecord(payload, length, handler, result.events)) {
+            result.damaged = true;
+            break;
+        }
+
+        pos += RECORD_HEADER_SIZE + length;
+        ++result.records;
+    }
+
+    result.validBytes = pos;
+    result.unreadBytes = contents.size() - pos;
+    return result;
+}
+
+bool EventLog::open(const std::string& path, const ReplayHandler& handler, ReplayResult* result) {
+    close();
+
+    ReplayResult replayed = replay(path, handler);
+    if (result != nullptr) *result = replayed;
+    if (replayed.damaged && replayed.validBytes == 0) {
+        std::cout << "Error: " << path << " is not an event log" << std::endl;
+        return false;
+    }
+    if (replayed.damaged) {
+        std::cout << "Error: Event log " << path << " is damaged at byte " << replayed.validBytes << "; the "
+                  << replayed.unreadBytes << " bytes after it were not replayed. Move the file aside to start a new log."
+                  << std::endl;
+        return false;
+    }
+
+    int newFd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (newFd < 0) {
+        std::cout << "Error: Could not open event log " << path << std::endl;
+        return false;
+    }
+
+    // Drop a torn tail left by a crash so new records follow the last good one.
+    off_t keep = static_cast<off_t>(replayed.validBytes);
+    if (keep == 0) {
+        if (ftruncate(newFd, 0) != 0 || !writeAll(newFd, LOG_MAGIC, sizeof(LOG_MAGIC))) {
+            ::close(newFd);
+            return false;
+        }
+        keep = sizeof(LOG_MAGIC);
+    } else if (replayed.truncatedTail && ftruncate(newFd, keep) != 0) {
+        ::close(newFd);
+        return false;
+    }
+    if (lseek(newFd, keep, SEEK_SET) < 0) {
+        ::close(newFd);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    fd = newFd;
+    pending.clear();
+    queuedSeq = 0;
+    committedSeq = 0;
+    stopping = false;
+    writeFailed = false;
+    writer = std::thread(&EventLog::writerLoop, this);
+    return true;
+}
+
+bool EventLog::isOpen() const {
+    std::lock_guard<std::mutex> lock(logMutex);
+    return fd >= 0 && !stopping;
+}
+
+void EventLog::appendEvent(const std::string& canonicalGame, const Event& event) {
+    std::string payload;
+    payload.reserve(64 + event.get_description().size());
+    payload.push_back(static_cast<char>(RECORD_EVENT));
+    putString(payload, canonicalGame);
+    putString(payload, event.get_event_owner());
+    putString(payload, event.get_team_a_name());
+    putString(payload, event.get_team_b_name());
+    putString(payload, event.get_name());
+    putU32(payload, static_cast<std::uint32_t>(event.get_time()));
+    putMap(payload, event.get_game_updates());
+    putMap(payload, event.get_team_a_updates());
+    putMap(payload, event.get_team_b_updates());
+    putString(payload, event.get_description());
+    enqueue(sealRecord(payload));
+}
+
+void EventLog::appendClearTimeline(const std::string& canonicalGame, const std::string& owner) {
+    std::string payload;
+    payload.push_back(static_cast<char>(RECORD_CLEAR_TIMELINE));
+    putString(payload, canonicalGame);
+    putString(payload, owner);
+    enqueue(sealRecord(payload));
+}
+
+void EventLog::enqueue(const std::string& record) {
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        if (fd < 0 || stopping) return;
+        pending.append(record);
+        ++queuedSeq;
+    }
+    workAvailable.notify_one();
+}
+
+void EventLog::flush() {
+    std::unique_lock<std::mutex> lock(logMutex);
+    std::uint64_t target = queuedSeq;
+    batchCommitted.wait(lock, [&] { return committedSeq >= target || writeFailed || fd < 0; });
+}
+
+bool EventLog::truncate() {
+    flush();
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (fd < 0 || writeFailed) return false;
+    off_t keep = sizeof(LOG_MAGIC);
+    return ftruncate(fd, keep) == 0 && lseek(fd, keep, SEEK_SET) == keep && fdatasync(fd) == 0;
+}
+
+void EventLog::close() {
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        if (fd < 0) return;
+        stopping = true;
+    }
+    workAvailable.notify_one();
+    if (writer.joinable()) writer.join();
+
+    std::lock_guard<std::mutex> lock(logMutex);
+    ::close(fd);
+    fd = -1;
+    batchCommitted.notify_all();
+}
+
+// Group commit: everything queued while the previous batch was being
+// written goes out in a single write + fdatasync.
+void EventLog::writerLoop() {
+    std::string batch;
+    std::unique_lock<std::mutex> lock(logMutex);
+    while (true) {
+        workAvailable.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (pending.empty() && stopping) break;
+
+        batch.swap(pending);
+        std::uint64_t batchSeq = queuedSeq;
+        int writeFd = fd;
+        lock.unlock();
+
+        bool ok = writeAll(writeFd, batch.data(), batch.size()) && fdatasync(writeFd) == 0;
+        batch.clear();
+
+        lock.lock();
+        if (!ok && !writeFailed) {
+            writeFailed = true;
+            std::cout << "Error: Event log write failed; further events will not be persisted." << std::endl;
+        }
+        committedSeq = batchSeq;
+        batchCommitted.notify_all();
+        if (!ok) {
+            pending.clear();
+            stopping = true;
+        }
+    }
+}
@@ -0,0 +1,241 @@
+#include "../include/EventSnapshot.h"
+#include <cstring>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'T', 'O', 'M', 'P', 'S', 'N', 'P'};
+
+bool sectionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t entrySize, std::uint64_t fileSize) {
+    if (offset % 8 != 0 || offset > fileSize) return false;
+    return count <= (fileSize - offset) / entrySize;
+}
+
+template <typename T>
+bool writeSection(AtomicFileWriter& out, const std::vector<T>& entries) {
+    if (entries.empty()) return true;
+    return out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(T));
+}
+
+} // namespace
+
+EventSnapshotWriter::EventSnapshotWriter() :
+    games(), timelines(), events(), updates(), strings(), stringData(), stringIds(), currentGame() {}
+
+std::uint32_t EventSnapshotWriter::intern(const std::string& value) {
+    auto it = stringIds.find(value);
+    if (it != stringIds.end()) return it->second;
+
+    std::uint32_t id = static_cast<std::uint32_t>(strings.size());
+    snapshot::StringEntry entry = {stringData.size(), static_cast<std::uint32_t>(value.size()), 0};
+    strings.push_back(entry);
+    stringData.append(value);
+    stringIds.emplace(value, id);
+    return id;
+}
+
+void EventSnapshotWriter::addUpdates(const std::map<std::string, std::string>& values) {
+    for (const auto& entry : values) {
+        snapshot::UpdateEntry update = {intern(entry.first), intern(entry.second)};
+        updates.push_back(update);
+    }
+}
+
+void EventSnapshotWriter::addTimeline(const std::string& canonicalGame, const std::string& owner,
+                                      const std::vector<Event>& timeline) {
+    if (games.empty() || canonicalGame != currentGame) {
+        snapshot::GameEntry game = {intern(canonicalGame), static_cast<std::uint32_t>(timelines.size()), 0, 0};
+        games.push_back(game);
+        currentGame = canonicalGame;
+    }
+    ++games.back().timelineCount;
+
+    snapshot::TimelineEntry entry = {intern(owner), static_cast<std::uint32_t>(events.size()),
+                                     static_cast<std::uint32_t>(timeline.size()), 0};
+    timelines.push_back(entry);
+
+    for (const Event& event : timeline) {
+        snapshot::EventEntry record;
+        record.teamA = intern(event.get_team_a_name());
+        record.teamB = intern(event.get_team_b_name());
+        record.name = intern(event.get_name());
+        record.time = event.get_time();
+        record.description = intern(event.get_description());
+        record.owner = intern(event.get_event_owner());
+        record.firstUpdate = static_cast<std::uint32_t>(updates.size());
+        record.gameUpdates = static_cast<std::uint32_t>(event.get_game_updates().size());
+        record.teamAUpdates = static_cast<std::uint32_t>(event.get_team_a_updates().size());
+        record.teamBUpdates = static_cast<std::uint32_t>(event.get_team_b_updates().size());
+        addUpdates(event.get_game_updates());
+        addUpdates(event.get_team_a_updates());
+        addUpdates(event.get_team_b_updates());
+        events.push_back(record);
+    }
+}
+
+bool EventSnapshotWriter::write(const std::string& path) {
+    snapshot::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = snapshot::VERSION;
+    header.headerSize = sizeof(snapshot::Header);
+    header.gameCount = static_cast<std::uint32_t>(games.size());
+    header.timelineCount = static_cast<std::uint32_t>(timelines.size());
+    header.eventCount = static_cast<std::uint32_t>(events.size());
+    header.updateCount = static_cast<std::uint32_t>(updates.size());
+    header.stringCount = static_cast<std::uint32_t>(strings.size());
+
+    std::uint64_t offset = sizeof(snapshot::Header);
+    header.gamesOffset = offset;
+    offset += games.size() * sizeof(snapshot::GameEntry);
+    header.timelinesOffset = offset;
+    offset += timelines.size() * sizeof(snapshot::TimelineEntry);
+    header.eventsOffset = offset;
+    offset += events.size() * sizeof(snapshot::EventEntry);
+    header.updatesOffset = offset;
+    offset += updates.size() * sizeof(snapshot::UpdateEntry);
+    header.stringIndexOffset = offset;
+    offset += strings.size() * sizeof(snapshot::StringEntry);
+    header.stringDataOffset = offset;
+    header.stringDataSize = stringData.size();
+
+    AtomicFileWriter out;
+    if (!out.open(path)) return false;
+    bool ok = out.write(reinterpret_cast<const char*>(&header), sizeof(header)) &&
+              writeSection(out, games) &&
+              writeSection(out, timelines) &&
+              writeSection(out, events) &&
+              writeSection(out, updates) &&
+              writeSection(out, strings) &&
+              out.write(stringData.data(), stringData.size());
+    if (!ok) return false;
+    return out.commit();
+}
+
+EventSnapshot::EventSnapshot() : file(), header(nullptr) {}
+
+bool EventSnapshot::open(const std::string& path, std::string& error) {
+    close();
+    if (!file.open(path)) {
+        error = "cannot map " + path;
+        return false;
+    }
+
+    std::uint64_t size = file.size();
+    if (size < sizeof(snapshot::Header)) {
+        error = "file too small";
+        close();
+        return false;
+    }
+
+    const snapshot::Header* candidate = reinterpret_cast<const snapshot::Header*>(file.data());
+    if (std::memcmp(candidate->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        candidate->version != snapshot::VERSION || candidate->headerSize != sizeof(snapshot::Header)) {
+        error = "not a version " + std::to_string(snapshot::VERSION) + " snapshot";
+        close();
+        return false;
+    }
+
+    bool fits =
+        sectionFits(candidate->gamesOffset, candidate->gameCount, sizeof(snapshot::GameEntry), size) &&
+        sectionFits(candidate->timelinesOffset, candidate->timelineCount, sizeof(snapshot::TimelineEntry), size) &&
+        sectionFits(candidate->eventsOffset, candidate->eventCount, sizeof(snapshot::EventEntry), size) &&
+        sectionFits(candidate->updatesOffset, candidate->updateCount, sizeof(snapshot::UpdateEntry), size) &&
+        sectionFits(candidate->stringIndexOffset, candidate->stringCount, sizeof(snapshot::StringEntry), size) &&
+        candidate->stringDataOffset <= size && candidate->stringDataSize <= size - candidate->stringDataOffset;
+    if (!fits) {
+        error = "section out of bounds";
+        close();
+        return false;
+    }
+
+    header = candidate;
+    return true;
+}
+
+void EventSnapshot::close() {
+    file.close();
+    header = nullptr;
+}
+
+bool EventSnapshot::isOpen() const { return header != nullptr; }
+
+std::size_t EventSnapshot::gameCount() const { return header == nullptr ? 0 : header->gameCount; }
+
+std::size_t EventSnapshot::eventCount() const { return header == nullptr ? 0 : header->eventCount; }
+
+template <typename T>
+const T* EventSnapshot::section(std::uint64_t offset) const {
+    return reinterpret_cast<const T*>(file.data() + offset);
+}
+
+bool EventSnapshot::string(std::uint32_t id, std::string& out) const {
+    if (id >= header->stringCount) return false;
+    const snapshot::StringEntry& entry = section<snapshot::StringEntry>(header->stringIndexOffset)[id];
+    if (entry.offset > header->stringDataSize || entry.length > header->stringDataSize - entry.offset) return false;
+    out.assign(file.data() + header->stringDataOffset + entry.offset, entry.length);
+    return true;
+}
+
+std::string EventSnapshot::gameName(std::size_t game) const {
+    std::string name;
+    if (header != nullptr && game < header->gameCount) {
+        string(section<snapshot::GameEntry>(header->gamesOffset)[game].name, name);
+    }
+    return name;
+}
+
+bool EventSnapshot::readUpdates(std::uint64_t first, std::uint64_t count,
+                                std::map<std::string, std::string>& out) const {
+    if (first > header->updateCount || count > header->updateCount - first) return false;
+    const snapshot::UpdateEntry* entries = section<snapshot::UpdateEntry>(header->updatesOffset) + first;
+    std::string key;
+    std::string value;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        if (!string(entries[i].key, key) || !string(entries[i].value, value)) return false;
+        out.emplace_hint(out.end(), key, value);
+    }
+    return true;
+}
+
+bool EventSnapshot::materializeGame(std::size_t game, const TimelineSink& sink) const {
+    if (header == nullptr || game >= header->gameCount) return false;
+    const snapshot::GameEntry& gameEntry = section<snapshot::GameEntry>(header->gamesOffset)[game];
+    if (gameEntry.firstTimeline > header->timelineCount ||
+        gameEntry.timelineCount > header->timelineCount - gameEntry.firstTimeline) {
+        return false;
+    }
+
+    const snapshot::TimelineEntry* timelineEntries =
+        section<snapshot::TimelineEntry>(header->timelinesOffset) + gameEntry.firstTimeline;
+    const snapshot::EventEntry* eventEntries = section<snapshot::EventEntry>(header->eventsOffset);
+
+    for (std::uint32_t t = 0; t < gameEntry.timelineCount; ++t) {
+        const snapshot::TimelineEntry& timeline = timelineEntries[t];
+        std::string owner;
+        if (!string(timeline.owner, owner) || timeline.firstEvent > header->eventCount ||
+            timeline.eventCount > header->eventCount - timeline.firstEvent) {
+            return false;
+        }
+
+        std::vector<Event> events;
+        events.reserve(timeline.eventCount);
+        for (std::uint32_t e = 0; e < timeline.eventCount; ++e) {
+            const snapshot::EventEntry& record = eventEntries[timeline.firstEvent + e];
+            std::string teamA, teamB, name, description, eventOwner;
+            std::map<std::string, std::string> gameUpdates, teamAUpdates, teamBUpdates;
+            std::uint64_t update = record.firstUpdate;
+            bool ok = string(record.teamA, teamA) && string(record.teamB, teamB) &&
+                      string(record.name, name) && string(record.description, description) &&
+                      string(record.owner, eventOwner) &&
+                      readUpdates(update, record.gameUpdates, gameUpdates) &&
+                      readUpdates(update + record.gameUpdates, record.teamAUpdates, teamAUpdates) &&
+                      readUpdates(update + record.gameUpdates + record.teamAUpdates, record.teamBUpdates, teamBUpdates);
+            if (!ok) return false;
+
+            events.push_back(Event(teamA, teamB, name, record.time, gameUpdates, teamAUpdates, teamBUpdates, description));
+            events.back().set_event_owner(eventOwner);
+        }
+        sink(owner, events);
+    }
+    return true;
+}
@@ -0,0 +1,143 @@
+#include "../include/FileUtil.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile() : mapped(nullptr), length(0), opened(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<std::size_t>(st.st_size);
+    if (length > 0) {
+        void* region = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (region == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        mapped = static_cast<const char*>(region);
+    }
+    ::close(fd);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped != nullptr) {
+        munmap(const_cast<char*>(mapped), length);
+    }
+    mapped = nullptr;
+    length = 0;
+    opened = false;
+}
+
+bool MappedFile::isOpen() const { return opened; }
+
+const char* MappedFile::data() const { return mapped; }
+
+std::size_t MappedFile::size() const { return length; }
+
+AtomicFileWriter::AtomicFileWriter() : finalPath(), tempPath(), fd(-1), failed(false) {}
+
+AtomicFileWriter::~AtomicFileWriter() {
+    abort();
+}
+
+bool AtomicFileWriter::open(const std::string& path) {
+    abort();
+    finalPath = path;
+    tempPath = path + ".tmp." + std::to_string(getpid());
+    failed = false;
+    fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return fd >= 0;
+}
+
+bool AtomicFileWriter::copyAttributes(const struct stat& existing) {
+    if (fd < 0) return false;
+    struct stat own;
+    if (fstat(fd, &own) != 0) return false;
+    // chown before chmod: changing the owner clears set-user-ID bits.
+    if ((own.st_uid != existing.st_uid || own.st_gid != existing.st_gid) &&
+        fchown(fd, existing.st_uid, existing.st_gid) != 0) {
+        return false;
+    }
+    return fchmod(fd, existing.st_mode & 07777) == 0;
+}
+
+bool AtomicFileWriter::write(const char* data, std::size_t len) {
+    if (fd < 0 || failed) return false;
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            failed = true;
+            return false;
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool AtomicFileWriter::commit(bool durable) {
+    if (fd < 0) return false;
+    bool ok = !failed && (!durable || fsync(fd) == 0);
+    ok = ::close(fd) == 0 && ok;
+    fd = -1;
+    if (ok) ok = std::rename(tempPath.c_str(), finalPath.c_str()) == 0;
+    if (!ok) std::remove(tempPath.c_str());
+    tempPath.clear();
+    return ok;
+}
+
+void AtomicFileWriter::abort() {
+    if (fd < 0) return;
+    ::close(fd);
+    fd = -1;
+    std::remove(tempPath.c_str());
+    tempPath.clear();
+}
+
+bool replaceFileContents(const std::string& path, const std::string& data) {
+    // lstat, not stat: renaming over a symlink would replace the link itself.
+    struct stat st;
+    bool exists = lstat(path.c_str(), &st) == 0;
+    bool replaceable = exists ? S_ISREG(st.st_mode) : errno == ENOENT;
+    AtomicFileWriter atomic;
+    // A file whose owner cannot be carried over is written in place instead.
+    if (replaceable && atomic.open(path) && (!exists || atomic.copyAttributes(st))) {
+        return atomic.write(data.data(), data.size()) && atomic.commit(false);
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    const char* pos = data.data();
+    std::size_t left = data.size();
+    bool ok = true;
+    while (ok && left > 0) {
+        ssize_t n = ::write(fd, pos, left);
+        if (n < 0 && errno == EINTR) continue;
+        ok = n >= 0;
+        if (ok) {
+            pos += n;
+            left -= static_cast<std::size_t>(n);
+        }
+    }
+    return ::close(fd) == 0 && ok;
+}
@@ -0,0 +1,109 @@
+#include "../include/FrameCapture.h"
+#include "../include/Trace.h"
+#include <cstring>
+
+namespace {
+
+const char CAPTURE_MAGIC[8] = {'S', 'T', 'O', 'M', 'P', 'C', 'P', '1'};
+const std::size_t RECORD_HEADER_SIZE = 12;
+const std::size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+} // namespace
+
+FrameCaptureWriter::FrameCaptureWriter() : file(nullptr), startNanos(0), recorded(0), captureMutex() {}
+
+FrameCaptureWriter::~FrameCaptureWriter() {
+    close();
+}
+
+bool FrameCaptureWriter::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (file != nullptr) std::fclose(file);
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    std::setvbuf(file, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+    if (std::fwrite(CAPTURE_MAGIC, 1, sizeof(CAPTURE_MAGIC), file) != sizeof(CAPTURE_MAGIC)) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    startNanos = monotonicNanos();
+    recorded = 0;
+    return true;
+}
+
+bool FrameCaptureWriter::isOpen() const {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    return file != nullptr;
+}
+
+void FrameCaptureWriter::record(const std::string& frame) {
+    std::uint64_t offset = monotonicNanos();
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (file == nullptr) return;
+    offset -= startNanos;
+    std::uint32_t length = static_cast<std::uint32_t>(frame.size());
+    char header[RECORD_HEADER_SIZE];
+    std::memcpy(header, &offset, sizeof(offset));
+    std::memcpy(header + sizeof(offset), &length, sizeof(length));
+    std::fwrite(header, 1, sizeof(header), file);
+    std::fwrite(frame.data(), 1, frame.size(), file);
+    ++recorded;
+}
+
+void FrameCaptureWriter::close() {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (file == nullptr) return;
+    std::fclose(file);
+    file = nullptr;
+}
+
+std::uint64_t FrameCaptureWriter::frames() const {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    return recorded;
+}
+
+FrameCaptureReader::FrameCaptureReader() : mapped(), pos(0), cutShort(false) {}
+
+bool FrameCaptureReader::open(const std::string& path, std::string& error) {
+    if (!mapped.open(path)) {
+        error = "cannot read file";
+        return false;
+    }
+    if (mapped.size() < sizeof(CAPTURE_MAGIC) ||
+        std::memcmp(mapped.data(), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+        mapped.close();
+        error = "not a frame capture";
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+bool FrameCaptureReader::next(Frame& frame) {
+    std::size_t remaining = mapped.size() - pos;
+    if (remaining == 0) return false;
+    std::uint32_t length = 0;
+    if (remaining >= RECORD_HEADER_SIZE) {
+        std::memcpy(&frame.offsetNanos, mapped.data() + pos, sizeof(frame.offsetNanos));
+        std::memcpy(&length, mapped.data() + pos + sizeof(frame.offsetNanos), sizeof(length));
+    }
+    if (remaining < RECORD_HEADER_SIZE || remaining - RECORD_HEADER_SIZE < length) {
+        cutShort = true;
+        pos = mapped.size();
+        return false;
+    }
+    frame.data = mapped.data() + pos + RECORD_HEADER_SIZE;
+    frame.size = length;
+    pos += RECORD_HEADER_SIZE + length;
+    return true;
+}
+
+void FrameCaptureReader::rewind() {
+    pos = sizeof(CAPTURE_MAGIC);
+    cutShort = false;
+}
+
+bool FrameCaptureReader::truncated() const {
+    return cutShort;
+}
@@ -0,0 +1,140 @@
+#include "../include/FramePacer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+TokenBucket::TokenBucket() : rate(0), burst(0), available(0), lastRefill() {}
+
+void TokenBucket::configure(double newRate, double newBurst) {
+    rate = newRate;
+    burst = newBurst;
+    available = newBurst;
+    lastRefill = std::chrono::steady_clock::now();
+}
+
+bool TokenBucket::enabled() const {
+    return rate > 0;
+}
+
+std::chrono::steady_clock::time_point TokenBucket::acquire(double tokens, std::chrono::steady_clock::time_point now) {
+    if (!enabled()) return now;
+
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    available = std::min(burst, available + elapsed * rate);
+    lastRefill = now;
+
+    available -= tokens;
+    if (available >= 0) return now;
+    return now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                     std::chrono::duration<double>(-available / rate));
+}
+
+FramePacer::FramePacer() :
+    current(), frames(), bytes(), batchStarted(false), replayDestination(), replayFirstTime(0), replayLastTime(0),
+    replayStart() {}
+
+void FramePacer::configure(const Settings& settings) {
+    current = settings;
+    // One second worth of burst, so short reports still go out at once.
+    frames.configure(settings.framesPerSecond, std::max(1.0, settings.framesPerSecond));
+    bytes.configure(settings.bytesPerSecond, settings.bytesPerSecond);
+    batchStarted = false;
+}
+
+const FramePacer::Settings& FramePacer::settings() const {
+    return current;
+}
+
+bool FramePacer::configure(const std::string& command) {
+    std::istringstream words(command);
+    std::string word;
+    words >> word;
+
+    Settings settings;
+    bool any = false;
+    while (words >> word) {
+        any = true;
+        if (word == "off") continue;
+        size_t eq = word.find('=');
+        char* end = nullptr;
+        double value = eq == std::string::npos ? -1 : std::strtod(word.c_str() + eq + 1, &end);
+        if (eq == std::string::npos || end == word.c_str() + eq + 1 || *end != '\0' || value < 0) {
+            any = false;
+            break;
+        }
+        std::string key = word.substr(0, eq);
+        if (key == "frames") settings.framesPerSecond = value;
+        else if (key == "bytes") settings.bytesPerSecond = value;
+        else if (key == "replay") settings.replaySpeed = value;
+        else {
+            any = false;
+            break;
+        }
+    }
+    if (!any) {
+        std::cout << "Usage: pace off | pace [frames=<per-sec>] [bytes=<per-sec>] [replay=<speed>]" << std::endl;
+        return false;
+    }
+
+    configure(settings);
+    std::ostringstream summary;
+    summary << "Pacing: frames/sec ";
+    if (settings.framesPerSecond > 0) summary << settings.framesPerSecond; else summary << "unlimited";
+    summary << ", bytes/sec ";
+    if (settings.bytesPerSecond > 0) summary << settings.bytesPerSecond; else summary << "unlimited";
+    summary << ", replay ";
+    if (settings.replaySpeed > 0) summary << "x" << settings.replaySpeed; else summary << "off";
+    std::cout << summary.str() << std::endl;
+    return true;
+}
+
+void FramePacer::beginBatch() {
+    batchStarted = false;
+}
+
+bool FramePacer::eventTime(const std::string& frame, long& time) {
+    size_t body = frame.find("\n\n");
+    if (body == std::string::npos) return false;
+    size_t pos = frame.find("\ntime:", body);
+    if (pos == std::string::npos) return false;
+    const char* start = frame.c_str() + pos + 6;
+    char* end = nullptr;
+    time = std::strtol(start, &end, 10);
+    return end != start;
+}
+
+std::string FramePacer::destination(const std::string& frame) {
+    size_t pos = frame.find("\ndestination:");
+    size_t body = frame.find("\n\n");
+    if (pos == std::string::npos || pos >= body) return std::string();
+    pos += 13;
+    return frame.substr(pos, frame.find('\n', pos) - pos);
+}
+
+void FramePacer::beforeSend(const std::string& frame) {
+    if (frame.compare(0, 5, "SEND\n") != 0) return;
+
+    auto now = std::chrono::steady_clock::now();
+    auto ready = now;
+
+    long time = 0;
+    if (current.replaySpeed > 0 && eventTime(frame, time)) {
+        std::string game = destination(frame);
+        if (!batchStarted || time < replayLastTime || game != replayDestination) {
+            batchStarted = true;
+            replayDestination = game;
+            replayFirstTime = time;
+            replayStart = now;
+        }
+        replayLastTime = time;
+        double offset = static_cast<double>(time - replayFirstTime) / current.replaySpeed;
+        ready = std::max(ready, replayStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                  std::chrono::duration<double>(offset)));
+    }
+
+    ready = std::max(ready, frames.acquire(1, now));
+    ready = std::max(ready, bytes.acquire(static_cast<double>(frame.size() + 1), now));
+    if (ready > now) std::this_thread::sleep_until(ready);
+}
@@ -0,0 +1,103 @@
+#include "../include/GameIdCache.h"
+#include <cstring>
+
+namespace {
+
+std::uint64_t hashBytes(const char* data, std::size_t length) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+const std::size_t GameIdCache::INITIAL_SLOTS;
+const std::size_t GameIdCache::MAX_SLOTS;
+
+GameIdCache::GameIdCache(Normalizer normalize) :
+    normalize(normalize), slots(INITIAL_SLOTS), usedSlots(0), rawArena(), names(), ids() {}
+
+// Index of the slot holding raw, or of the empty slot where it belongs.
+// slots.size() is a power of two and never full, so the probe terminates.
+std::size_t GameIdCache::probe(std::uint64_t hash, const char* raw, std::size_t length) const {
+    std::size_t mask = slots.size() - 1;
+    std::size_t index = static_cast<std::size_t>(hash) & mask;
+    while (slots[index].used) {
+        const Slot& slot = slots[index];
+        if (slot.hash == hash && slot.length == length &&
+            std::memcmp(rawArena.data() + slot.offset, raw, length) == 0) {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+GameId GameIdCache::resolve(const char* raw, std::size_t length) {
+    std::uint64_t hash = hashBytes(raw, length);
+    const Slot& slot = slots[probe(hash, raw, length)];
+    if (slot.used) return slot.id;
+
+    std::string canonical = normalize(std::string(raw, length));
+    GameId id = canonical.empty() ? NO_GAME : intern(canonical);
+    insertRaw(hash, raw, length, id);
+    return id;
+}
+
+void GameIdCache::insertRaw(std::uint64_t hash, const char* raw, std::size_t length, GameId id) {
+    if ((usedSlots + 1) * 2 > slots.size()) {
+        if (slots.size() < MAX_SLOTS) {
+            rehash(slots.size() * 2);
+        } else {
+            slots.assign(slots.size(), Slot());
+            usedSlots = 0;
+            rawArena.clear();
+        }
+    }
+
+    Slot& slot = slots[probe(hash, raw, length)];
+    slot.hash = hash;
+    slot.offset = static_cast<std::uint32_t>(rawArena.size());
+    slot.length = static_cast<std::uint32_t>(length);
+    slot.id = id;
+    slot.used = true;
+    rawArena.append(raw, length);
+    ++usedSlots;
+}
+
+void GameIdCache::rehash(std::size_t slotCount) {
+    std::vector<Slot> old(slotCount);
+    old.swap(slots);
+    std::size_t mask = slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (!slot.used) continue;
+        std::size_t index = static_cast<std::size_t>(slot.hash) & mask;
+        while (slots[index].used) index = (index + 1) & mask;
+        slots[index] = slot;
+    }
+}
+
+GameId GameIdCache::intern(const std::string& canonical) {
+    auto it = ids.find(canonical);
+    if (it != ids.end()) return it->second;
+    GameId id = static_cast<GameId>(names.size());
+    names.push_back(canonical);
+    ids.emplace(canonical, id);
+    return id;
+}
+
+GameId GameIdCache::find(const std::string& canonical) const {
+    auto it = ids.find(canonical);
+    return it == ids.end() ? NO_GAME : it->second;
+}
+
+const std::string& GameIdCache::name(GameId id) const {
+    return names[static_cast<std::size_t>(id)];
+}
+
+std::size_t GameIdCache::size() const {
+    return names.size();
+}
@@ -0,0 +1,66 @@
+#include "../include/LatencyHistogram.h"
+#include <cmath>
+
+namespace {
+
+const unsigned SUB_BUCKET_BITS = 5;
+const std::uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+// Group 0 holds the exact values below SUB_BUCKETS; group g > 0 covers
+// [SUB_BUCKETS << (g - 1), SUB_BUCKETS << g).
+const std::size_t GROUPS = 64 - SUB_BUCKET_BITS + 1;
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() : buckets(GROUPS * SUB_BUCKETS, 0), total(0), maxValue(0) {}
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) return static_cast<std::size_t>(nanos);
+    unsigned shift = 63 - static_cast<unsigned>(__builtin_clzll(nanos)) - SUB_BUCKET_BITS;
+    std::uint64_t subBucket = (nanos >> shift) - SUB_BUCKETS;
+    return static_cast<std::size_t>((shift + 1) * SUB_BUCKETS + subBucket);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    std::size_t group = bucket / SUB_BUCKETS;
+    std::uint64_t subBucket = bucket % SUB_BUCKETS;
+    if (group == 0) return subBucket;
+    unsigned shift = static_cast<unsigned>(group - 1);
+    return ((SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t nanos) {
+    ++buckets[bucketOf(nanos)];
+    ++total;
+    if (nanos > maxValue) maxValue = nanos;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < buckets.size(); ++i) buckets[i] += other.buckets[i];
+    total += other.total;
+    if (other.maxValue > maxValue) maxValue = other.maxValue;
+}
+
+void LatencyHistogram::reset() {
+    buckets.assign(buckets.size(), 0);
+    total = 0;
+    maxValue = 0;
+}
+
+std::uint64_t LatencyHistogram::count() const { return total; }
+
+std::uint64_t LatencyHistogram::max() const { return maxValue; }
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+    if (rank == 0) rank = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            std::uint64_t bound = bucketUpperBound(i);
+            return bound < maxValue ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
@@ -0,0 +1,217 @@
+#include "../include/LoopbackBroker.h"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+const std::size_t READ_CHUNK = 64 * 1024;
+
+bool writeAll(int fd, const char* data, std::size_t length) {
+    while (length > 0) {
+        ssize_t written = ::send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        length -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+bool loopbackTcpPair(int fds[2]) {
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    int client = -1;
+    int accepted = -1;
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 && ::listen(listener, 1) == 0 &&
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+        client = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (client >= 0 && ::connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            accepted = ::accept(listener, nullptr, nullptr);
+        }
+    }
+    ::close(listener);
+    if (accepted < 0) {
+        if (client >= 0) ::close(client);
+        return false;
+    }
+    int noDelay = 1;
+    setsockopt(accepted, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    fds[0] = accepted;
+    fds[1] = client;
+    return true;
+}
+
+LoopbackBroker::LoopbackBroker()
+    : core(*this), connectionsMutex(), connections(), nextConnectionId(1), listenFd(-1), acceptor(), stopping(false) {}
+
+LoopbackBroker::~LoopbackBroker() {
+    stop();
+}
+
+int LoopbackBroker::connectPair() {
+    int fds[2];
+    if (!loopbackTcpPair(fds)) return -1;
+    if (addConnection(fds[0]) < 0) {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        return -1;
+    }
+    return fds[1];
+}
+
+int LoopbackBroker::listen(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return 0;
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    socklen_t length = sizeof(address);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 128) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        ::close(fd);
+        return 0;
+    }
+    listenFd = fd;
+    acceptor = std::thread(&LoopbackBroker::acceptLoop, this);
+    return ntohs(address.sin_port);
+}
+
+void LoopbackBroker::stop() {
+    stopping = true;
+    if (listenFd >= 0) {
+        ::shutdown(listenFd, SHUT_RDWR);
+        if (acceptor.joinable()) acceptor.join();
+        ::close(listenFd);
+        listenFd = -1;
+    }
+
+    std::map<int, std::unique_ptr<Connection>> closing;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        closing.swap(connections);
+    }
+    for (auto& entry : closing) {
+        Connection& connection = *entry.second;
+        {
+            std::lock_guard<std::mutex> lock(connection.writeMutex);
+            if (connection.fd >= 0) ::shutdown(connection.fd, SHUT_RDWR);
+        }
+        if (connection.reader.joinable()) connection.reader.join();
+    }
+}
+
+void LoopbackBroker::send(int connectionId, const std::string& frame) {
+    Connection* connection = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        auto it = connections.find(connectionId);
+        if (it != connections.end()) connection = it->second.get();
+    }
+    if (connection == nullptr) return;
+    std::lock_guard<std::mutex> lock(connection->writeMutex);
+    if (connection->closing) return;
+    connection->outbound.append(frame).push_back('\0');
+    connection->queued.notify_one();
+}
+
+int LoopbackBroker::addConnection(int fd) {
+    std::lock_guard<std::mutex> lock(connectionsMutex);
+    if (stopping) return -1;
+    int id = nextConnectionId++;
+    std::unique_ptr<Connection> connection(new Connection(fd));
+    Connection& added = *connection;
+    connections[id] = std::move(connection);
+    added.reader = std::thread(&LoopbackBroker::serve, this, id, std::ref(added));
+    return id;
+}
+
+void LoopbackBroker::serve(int connectionId, Connection& connection) {
+    BrokerCore::Session session(connectionId);
+    std::thread writer(&LoopbackBroker::writeLoop, this, std::ref(connection));
+    std::vector<char> buffer(READ_CHUNK);
+    std::string frame;
+    bool open = true;
+    while (open) {
+        ssize_t received = ::recv(connection.fd, buffer.data(), buffer.size(), 0);
+        if (received <= 0) break;
+        const char* pos = buffer.data();
+        const char* end = pos + received;
+        while (open && pos < end) {
+            const char* nul = static_cast<const char*>(std::memchr(pos, '\0', static_cast<std::size_t>(end - pos)));
+            if (nul == nullptr) {
+                frame.append(pos, end);
+                break;
+            }
+            frame.append(pos, nul);
+            open = core.handle(session, frame);
+            frame.clear();
+            pos = nul + 1;
+        }
+    }
+    core.close(session);
+
+    // The writer sends what is still queued (e.g. the RECEIPT of a
+    // DISCONNECT) before the socket is closed.
+    {
+        std::lock_guard<std::mutex> lock(connection.writeMutex);
+        connection.closing = true;
+    }
+    connection.queued.notify_one();
+    writer.join();
+
+    std::lock_guard<std::mutex> lock(connection.writeMutex);
+    ::shutdown(connection.fd, SHUT_RDWR);
+    ::close(connection.fd);
+    connection.fd = -1;
+}
+
+void LoopbackBroker::writeLoop(Connection& connection) {
+    std::string batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(connection.writeMutex);
+            connection.queued.wait(lock, [&] { return !connection.outbound.empty() || connection.closing; });
+            if (connection.outbound.empty()) return;
+            batch.swap(connection.outbound);
+        }
+        // Written outside the lock; stop() shuts the socket down to end a
+        // write the peer never reads.
+        if (!writeAll(connection.fd, batch.data(), batch.size())) {
+            ::shutdown(connection.fd, SHUT_RDWR);
+            std::lock_guard<std::mutex> lock(connection.writeMutex);
+            connection.closing = true;
+            connection.outbound.clear();
+            return;
+        }
+        batch.clear();
+    }
+}
+
+void LoopbackBroker::acceptLoop() {
+    while (!stopping) {
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (stopping || errno != EINTR) return;
+            continue;
+        }
+        if (addConnection(fd) < 0) ::close(fd);
+    }
+}
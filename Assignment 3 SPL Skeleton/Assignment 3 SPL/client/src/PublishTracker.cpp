@@ -0,0 +1,40 @@
+#include "../include/PublishTracker.h"
+
+PublishTracker::PublishTracker() : allChannels(), byChannel(), streams() {}
+
+void PublishTracker::record(GameId game, const std::string& publisher, std::uint64_t sequence,
+                            std::uint64_t publishedAt, std::uint64_t deliveredAt) {
+    std::uint64_t latency = deliveredAt > publishedAt ? deliveredAt - publishedAt : 0;
+    allChannels.record(latency);
+    byChannel[game].record(latency);
+
+    Stream& stream = streams[std::make_pair(game, publisher)];
+    if (sequence == 1 && stream.highest > 1) {
+        stream.highest = 0;
+        stream.missing = 0;
+    }
+    ++stream.received;
+    if (sequence > stream.highest) {
+        stream.missing += sequence - stream.highest - 1;
+        stream.highest = sequence;
+    } else {
+        ++stream.reordered;
+        if (stream.missing > 0) --stream.missing;
+    }
+}
+
+void PublishTracker::clear() {
+    allChannels.reset();
+    byChannel.clear();
+    streams.clear();
+}
+
+bool PublishTracker::empty() const {
+    return allChannels.count() == 0;
+}
+
+void PublishTracker::writeLatency(std::ostream& out, const std::string& label, const LatencyHistogram& histogram) {
+    out << "  " << label << ": n=" << histogram.count() << " p50=" << histogram.percentile(50) / 1000.0
+        << "us p99=" << histogram.percentile(99) / 1000.0 << "us p999=" << histogram.percentile(99.9) / 1000.0
+        << "us max=" << histogram.max() / 1000.0 << "us" << std::endl;
+}
@@ -1,11 +1,18 @@
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <string>
 #include <vector>
+#include <unistd.h>
 #include "../include/ConnectionHandler.h"
 #include "../include/StompProtocol.h"
+#include "../include/FramePacer.h"
+#include "../include/StompFrame.h"
+#include "../include/ClientStats.h"
+#include "../include/Trace.h"
 
 void socketTask(ConnectionHandler* handler, StompProtocol& protocol) {
+    trace::setThreadName("socket reader");
     while (!protocol.isTerminated()) {
         std::string frame;
         if (!handler->getFrameAscii(frame, '\0')) {
@@ -22,14 +29,70 @@ void socketTask(ConnectionHandler* handler, StompProtocol& protocol) {
     }
 }
 
+// Sends every NUL-separated frame in frames, pacing SEND frames. Frames
+// with publish headers get their timestamp, and receipt round trips start,
+// just before the write.
+void sendFrames(ConnectionHandler* handler, StompProtocol& protocol, const std::string& frames, FramePacer& pacer) {
+    pacer.beginBatch();
+    std::uint64_t remaining = static_cast<std::uint64_t>(std::count(frames.begin(), frames.end(), '\0'));
+    if (!frames.empty() && frames.back() != '\0') ++remaining;
+    stats::setSendQueueDepth(remaining);
+
+    size_t start = 0;
+    while (start < frames.length()) {
+        size_t end = frames.find('\0', start);
+        if (end == std::string::npos) end = frames.length();
+        std::string singleFrame = frames.substr(start, end - start);
+        pacer.beforeSend(singleFrame);
+        std::uint64_t sentAt = monotonicNanos();
+        stampPublishTime(singleFrame, sentAt);
+        protocol.markFrameSent(singleFrame, sentAt);
+        handler->sendFrameAscii(singleFrame, '\0');
+        stats::count(stats::FRAMES_SENT);
+        stats::setSendQueueDepth(--remaining);
+        start = end + 1;
+    }
+}
+
 int main(int argc, char *argv[]) {
+    trace::setThreadName("input");
     StompProtocol protocol;
     ConnectionHandler* handler = nullptr;
+    FramePacer pacer;
+
+    std::string eventLogPath;
+    std::string snapshotPath;
+    FrameCaptureWriter capture;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--event-log" && i + 1 < argc) {
+            eventLogPath = argv[++i];
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (arg == "--capture" && i + 1 < argc) {
+            std::string capturePath = argv[++i];
+            if (!capture.open(capturePath)) {
+                std::cout << "Error: Could not create capture file " << capturePath << std::endl;
+                return 1;
+            }
+        } else {
+            std::cout << "Usage: StompWCIClient [--snapshot <path>] [--event-log <path>] [--capture <path>]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    // The snapshot is older than anything in the event log, so load it first.
+    if (!snapshotPath.empty() && access(snapshotPath.c_str(), F_OK) == 0 && !protocol.loadSnapshot(snapshotPath)) return 1;
+    if (!eventLogPath.empty() && !protocol.openEventLog(eventLogPath)) return 1;
 
     while (true) {
         std::string line;
         if (!std::getline(std::cin, line)) break;
         if (line.empty()) continue;
+        if (line.compare(0, 5, "pace ") == 0 || line == "pace") {
+            pacer.configure(line);
+            continue;
+        }
 
         if (handler == nullptr) {
             std::vector<std::string> words = protocol.split(line, ' ');
@@ -44,6 +107,7 @@ int main(int argc, char *argv[]) {
             short port = std::stoi(hostPort.substr(colonPos + 1));
 
             handler = new ConnectionHandler(host, port);
+            if (capture.isOpen()) handler->setCapture(&capture);
             if (!handler->connect()) {
                 std::cout << "Could not connect to server" << std::endl;
                 delete handler;
@@ -53,26 +117,21 @@ int main(int argc, char *argv[]) {
 
             std::string connectFrame = protocol.processInput(line);
             handler->sendFrameAscii(connectFrame, '\0');
+            stats::count(stats::FRAMES_SENT);
 
             std::thread readerThread(socketTask, handler, std::ref(protocol));
 
             while (!protocol.isTerminated()) {
                 std::string input;
                 if (!std::getline(std::cin, input)) break;
+                if (input.compare(0, 5, "pace ") == 0 || input == "pace") {
+                    pacer.configure(input);
+                    continue;
+                }
                 
                 std::string stompFrame = protocol.processInput(input);
                 if (!stompFrame.empty()) {
-                    size_t start = 0;
-                    size_t end = stompFrame.find('\0');
-                    while (end != std::string::npos) {
-                        std::string singleFrame = stompFrame.substr(start, end - start);
-                        handler->sendFrameAscii(singleFrame, '\0');
-                        start = end + 1;
-                        end = stompFrame.find('\0', start);
-                    }
-                    if (start < stompFrame.length()) {
-                        handler->sendFrameAscii(stompFrame.substr(start), '\0');
-                    }
+                    sendFrames(handler, protocol, stompFrame, pacer);
                 }
             }
 
@@ -85,5 +144,7 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (!snapshotPath.empty()) protocol.saveSnapshot(snapshotPath);
+    protocol.closeEventLog();
     return 0;
 }
\ No newline at end of file
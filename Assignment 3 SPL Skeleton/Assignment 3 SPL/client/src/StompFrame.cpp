@@ -0,0 +1,157 @@
+#include "../include/StompFrame.h"
+#include <cctype>
+
+namespace {
+
+std::size_t updatesSize(const std::map<std::string, std::string>& updates) {
+    std::size_t size = 0;
+    for (const auto& entry : updates) {
+        size += 4 + entry.first.size() + 1 + entry.second.size() + 1;
+    }
+    return size;
+}
+
+void appendUpdates(std::string& out, const std::map<std::string, std::string>& updates) {
+    for (const auto& entry : updates) {
+        out.append("    ", 4);
+        out.append(entry.first);
+        out.push_back(':');
+        out.append(entry.second);
+        out.push_back('\n');
+    }
+}
+
+void appendLine(std::string& out, const char* key, std::size_t keyLength, const std::string& value) {
+    out.append(key, keyLength);
+    out.append(value);
+    out.push_back('\n');
+}
+
+const char SEND_PREFIX[] = "SEND\ndestination:/";
+const char USER_KEY[] = "user:";
+const char TEAM_A_KEY[] = "team a:";
+const char TEAM_B_KEY[] = "team b:";
+const char EVENT_NAME_KEY[] = "event name:";
+const char TIME_KEY[] = "time:";
+const char GENERAL_UPDATES[] = "general game updates:\n";
+const char TEAM_A_UPDATES[] = "team a updates:\n";
+const char TEAM_B_UPDATES[] = "team b updates:\n";
+const char DESCRIPTION_KEY[] = "description:\n";
+const char PUBLISHER_KEY[] = "publisher:";
+const char PUBLISH_SEQ_KEY[] = "publish-seq:";
+// Fixed width so the timestamp can be written in place at send time.
+const char PUBLISH_TS_LINE[] = "\npublish-ts:";
+const std::size_t PUBLISH_TS_DIGITS = 20;
+
+std::size_t publishHeadersSize(const std::string& user, std::uint64_t sequence) {
+    if (sequence == 0) return 0;
+    return sizeof(PUBLISHER_KEY) - 1 + user.size() + 1 +
+           sizeof(PUBLISH_SEQ_KEY) - 1 + std::to_string(sequence).size() + 1 +
+           sizeof(PUBLISH_TS_LINE) - 2 + PUBLISH_TS_DIGITS + 1;
+}
+
+} // namespace
+
+std::size_t reportFrameSize(const std::string& destination, const std::string& user, const Event& event,
+                            std::uint64_t publishSequence) {
+    return sizeof(SEND_PREFIX) - 1 + destination.size() + 2 + publishHeadersSize(user, publishSequence) +
+           sizeof(USER_KEY) - 1 + user.size() + 1 +
+           sizeof(TEAM_A_KEY) - 1 + event.get_team_a_name().size() + 1 +
+           sizeof(TEAM_B_KEY) - 1 + event.get_team_b_name().size() + 1 +
+           sizeof(EVENT_NAME_KEY) - 1 + event.get_name().size() + 1 +
+           sizeof(TIME_KEY) - 1 + std::to_string(event.get_time()).size() + 1 +
+           sizeof(GENERAL_UPDATES) - 1 + updatesSize(event.get_game_updates()) +
+           sizeof(TEAM_A_UPDATES) - 1 + updatesSize(event.get_team_a_updates()) +
+           sizeof(TEAM_B_UPDATES) - 1 + updatesSize(event.get_team_b_updates()) +
+           sizeof(DESCRIPTION_KEY) - 1 + event.get_description().size() + 1 +
+           1;
+}
+
+void appendReportFrame(std::string& out, const std::string& destination, const std::string& user, const Event& event,
+                       std::uint64_t publishSequence) {
+    out.append(SEND_PREFIX, sizeof(SEND_PREFIX) - 1);
+    out.append(destination);
+    if (publishSequence != 0) {
+        out.push_back('\n');
+        appendLine(out, PUBLISHER_KEY, sizeof(PUBLISHER_KEY) - 1, user);
+        appendLine(out, PUBLISH_SEQ_KEY, sizeof(PUBLISH_SEQ_KEY) - 1, std::to_string(publishSequence));
+        out.append(PUBLISH_TS_LINE + 1, sizeof(PUBLISH_TS_LINE) - 2);
+        out.append(PUBLISH_TS_DIGITS, '0');
+    }
+    out.append("\n\n", 2);
+    appendLine(out, USER_KEY, sizeof(USER_KEY) - 1, user);
+    appendLine(out, TEAM_A_KEY, sizeof(TEAM_A_KEY) - 1, event.get_team_a_name());
+    appendLine(out, TEAM_B_KEY, sizeof(TEAM_B_KEY) - 1, event.get_team_b_name());
+    appendLine(out, EVENT_NAME_KEY, sizeof(EVENT_NAME_KEY) - 1, event.get_name());
+    appendLine(out, TIME_KEY, sizeof(TIME_KEY) - 1, std::to_string(event.get_time()));
+    out.append(GENERAL_UPDATES, sizeof(GENERAL_UPDATES) - 1);
+    appendUpdates(out, event.get_game_updates());
+    out.append(TEAM_A_UPDATES, sizeof(TEAM_A_UPDATES) - 1);
+    appendUpdates(out, event.get_team_a_updates());
+    out.append(TEAM_B_UPDATES, sizeof(TEAM_B_UPDATES) - 1);
+    appendUpdates(out, event.get_team_b_updates());
+    out.append(DESCRIPTION_KEY, sizeof(DESCRIPTION_KEY) - 1);
+    out.append(event.get_description());
+    out.push_back('\n');
+    out.push_back('\0');
+}
+
+bool stampPublishTime(std::string& frame, std::uint64_t nanos) {
+    std::size_t headerEnd = frame.find("\n\n");
+    std::size_t pos = frame.find(PUBLISH_TS_LINE);
+    if (pos == std::string::npos || pos >= headerEnd) return false;
+    pos += sizeof(PUBLISH_TS_LINE) - 1;
+    if (frame.size() < pos + PUBLISH_TS_DIGITS) return false;
+    for (std::size_t i = PUBLISH_TS_DIGITS; i > 0; --i) {
+        frame[pos + i - 1] = static_cast<char>('0' + nanos % 10);
+        nanos /= 10;
+    }
+    return true;
+}
+
+TextView TextView::trimmed() const {
+    std::size_t start = 0;
+    std::size_t end = size;
+    while (start < end && std::isspace(static_cast<unsigned char>(data[start]))) ++start;
+    while (end > start && std::isspace(static_cast<unsigned char>(data[end - 1]))) --end;
+    return TextView(data + start, end - start);
+}
+
+FrameView::FrameView(const std::string& frame) : commandText(), headerBlock(), bodyText(), bodyFound(false) {
+    const char* data = frame.data();
+    std::size_t size = frame.size();
+
+    std::size_t commandEnd = frame.find('\n');
+    if (commandEnd == std::string::npos) {
+        commandText = TextView(data, size);
+        return;
+    }
+    commandText = TextView(data, commandEnd);
+
+    std::size_t bodyPos = frame.find("\n\n");
+    if (bodyPos == std::string::npos) {
+        headerBlock = TextView(data + commandEnd + 1, size - commandEnd - 1);
+        return;
+    }
+    if (bodyPos > commandEnd) {
+        headerBlock = TextView(data + commandEnd + 1, bodyPos - commandEnd - 1);
+    }
+    bodyFound = true;
+    std::size_t bodyStart = bodyPos + 2;
+    std::size_t bodySize = size - bodyStart;
+    if (bodySize > 0 && data[size - 1] == '\0') --bodySize;
+    bodyText = TextView(data + bodyStart, bodySize);
+}
+
+TextView FrameView::header(const char* name) const {
+    std::size_t nameLength = std::strlen(name);
+    TextView value;
+    forEachLine(headerBlock, [&](const TextView& line) {
+        if (line.size > nameLength && line.data[nameLength] == ':' && line.startsWith(name, nameLength)) {
+            value = line.substr(nameLength + 1);
+            return false;
+        }
+        return true;
+    });
+    return value;
+}
@@ -1,5 +1,9 @@
 #include "../include/StompProtocol.h"
 #include "../include/event.h"
+#include "../include/StompFrame.h"
+#include "../include/SummaryRenderer.h"
+#include "../include/FileUtil.h"
+#include "../include/Trace.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -7,17 +11,36 @@
 #include <chrono>
 #include <thread>
 #include <cctype>
+#include <set>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <dirent.h>
+#include <sys/stat.h>
 
 StompProtocol::StompProtocol() : 
     currentUsername(""), 
     subscriptionCounter(0), 
     receiptCounter(0), 
-    subIdToCanonical(), 
-    canonicalToSubId(), 
+    subIdToGame(), 
+    gameToSubId(), 
     receiptIdToCommand(), 
-    canonicalToDestination(),
+    receiptSentAt(),
+    gameIds(&StompProtocol::normalizeGameName),
+    gameDestinations(),
+    subscriptionFilters(),
     gameReports(), 
-    shouldTerminate(false) {}
+    eventIndex(),
+    eventLog(),
+    eventLogEnabled(false),
+    snapshot(),
+    snapshotGames(),
+    reportWorkers(),
+    publishTimestamps(false),
+    publishSequences(),
+    publishTracker(),
+    shouldTerminate(false),
+    statsDump() {}
 
 std::string StompProtocol::trim(const std::string& value) {
     size_t start = 0;
@@ -75,26 +98,80 @@ static std::string canonicalToPretty(const std::string& canonical) {
     return pretty;
 }
 
-std::string StompProtocol::resolveDestinationForCanonical(const std::string& canonical) const {
-    auto it = canonicalToDestination.find(canonical);
-    if (it != canonicalToDestination.end() && !it->second.empty()) {
+std::string StompProtocol::resolveDestination(GameId game) const {
+    auto it = gameDestinations.find(game);
+    if (it != gameDestinations.end() && !it->second.empty()) {
         return it->second;
     }
-    return canonicalToPretty(canonical);
+    return canonicalToPretty(gameIds.name(game));
 }
 
-void StompProtocol::storeEvent(const std::string& canonicalGame, const Event& event) {
-    std::string ownerKey = canonicalOwner(event);
-    auto& eventsForUser = gameReports[canonicalGame][ownerKey];
+void StompProtocol::storeEvent(GameId game, const Event& event) {
+    trace::Span span("storeEvent");
+    stats::count(stats::EVENTS_STORED);
+    if (insertEvent(game, event)) stats::count(stats::EVENTS_REPLACED);
+    if (eventLogEnabled) {
+        eventLog.appendEvent(gameIds.name(game), event);
+    }
+}
+
+bool StompProtocol::insertEvent(GameId game, const Event& event) {
+    materializeSnapshotGame(game);
+    auto gameIt = gameReports.emplace(game, std::map<std::string, Timeline>()).first;
+    auto ownerIt = gameIt->second.emplace(canonicalOwner(event), Timeline()).first;
+    Timeline& timeline = ownerIt->second;
+    const std::vector<Event>& eventsForUser = timeline.events;
 
     auto existing = std::find_if(eventsForUser.begin(), eventsForUser.end(), [&](const Event& current) {
         return current.get_time() == event.get_time() && current.get_name() == event.get_name();
     });
 
     if (existing != eventsForUser.end()) {
-        *existing = event;
-    } else {
-        eventsForUser.push_back(event);
+        std::size_t position = static_cast<std::size_t>(existing - eventsForUser.begin());
+        timeline.replace(position, event);
+        eventIndex.replace(eventsForUser, position);
+        return true;
+    }
+    timeline.append(event);
+    eventIndex.add(gameIds.name(game), ownerIt->first, eventsForUser, eventsForUser.size() - 1);
+    return false;
+}
+
+void StompProtocol::materializeSnapshotGame(GameId game) {
+    if (snapshotGames.empty()) return;
+    auto pending = snapshotGames.find(game);
+    if (pending == snapshotGames.end()) return;
+    std::size_t index = pending->second;
+    snapshotGames.erase(pending);
+
+    bool ok = snapshot.materializeGame(index, [&](const std::string& owner, std::vector<Event>& events) {
+        auto gameIt = gameReports.emplace(game, std::map<std::string, Timeline>()).first;
+        auto ownerIt = gameIt->second.emplace(owner, Timeline()).first;
+        Timeline& timeline = ownerIt->second;
+        if (timeline.events.empty()) {
+            timeline.adopt(events);
+            for (std::size_t i = 0; i < timeline.events.size(); ++i) {
+                eventIndex.add(gameIds.name(game), ownerIt->first, timeline.events, i);
+            }
+            return;
+        }
+        for (const Event& event : events) {
+            insertEvent(game, event);
+        }
+    });
+    if (!ok) {
+        std::cout << "Warning: Snapshot data for " << gameIds.name(game) << " is corrupt and was skipped." << std::endl;
+    }
+    if (snapshotGames.empty()) snapshot.close();
+}
+
+void StompProtocol::clearTimeline(GameId game, const std::string& owner) {
+    materializeSnapshotGame(game);
+    Timeline& timeline = gameReports[game][owner];
+    eventIndex.removeTimeline(timeline.events);
+    timeline.clear();
+    if (eventLogEnabled) {
+        eventLog.appendClearTimeline(gameIds.name(game), owner);
     }
 }
 
@@ -103,123 +180,479 @@ std::string StompProtocol::canonicalOwner(const Event& event) {
     return owner.empty() ? "unknown" : owner;
 }
 
-std::size_t StompProtocol::eventDetailScore(const Event& event) {
-    std::size_t score = 0;
-    score += event.get_game_updates().size();
-    score += event.get_team_a_updates().size();
-    score += event.get_team_b_updates().size();
-    if (!event.get_description().empty()) score += event.get_description().size();
-    if (!event.get_name().empty()) score += 1;
-    return score;
+// The target user's timeline if it is complete, otherwise the most detailed
+// complete timeline reported by anyone else, otherwise whatever the target
+// user has. Only per-timeline aggregates are read, never the events.
+const Timeline* StompProtocol::selectTimelineForSummary(GameId game, const std::string& targetUser) const {
+    auto gameIt = gameReports.find(game);
+    if (gameIt == gameReports.end()) return nullptr;
+
+    const Timeline* own = nullptr;
+    auto userIt = gameIt->second.find(targetUser);
+    if (userIt != gameIt->second.end()) {
+        own = &userIt->second;
+        if (own->isComplete()) return own;
+    }
+
+    const Timeline* best = nullptr;
+    std::size_t bestScore = 0;
+    for (const auto& ownerEntry : gameIt->second) {
+        const Timeline& timeline = ownerEntry.second;
+        if (ownerEntry.first == targetUser || !timeline.isComplete()) continue;
+        if (timeline.detailScore > bestScore) {
+            bestScore = timeline.detailScore;
+            best = &timeline;
+        }
+    }
+
+    return best != nullptr ? best : own;
+}
+
+namespace {
+
+struct ReportFile {
+    ReportFile() : path(), parsed(), canonicalGame(), destination(), error(), accepted(false), firstSequence(0),
+                   frames() {}
+    std::string path;
+    names_and_events parsed;
+    std::string canonicalGame;
+    std::string destination;
+    std::string error;
+    bool accepted;
+    // Publish sequence of the first event, or 0 when timestamps are off.
+    std::uint64_t firstSequence;
+    std::string frames;
+};
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
 }
 
-bool StompProtocol::timelineHasRequiredEvents(const std::vector<Event>& events) {
-    bool hasKickoff = false;
-    bool hasHalftime = false;
-    bool hasGoal = false;
-    bool hasFinalWhistle = false;
+// Replaces every directory argument by the .json files directly inside it,
+// in name order.
+std::vector<std::string> expandReportPaths(const std::vector<std::string>& words) {
+    std::vector<std::string> paths;
+    for (std::size_t i = 1; i < words.size(); ++i) {
+        const std::string& arg = words[i];
+        if (arg.empty()) continue;
 
-    for (const Event& event : events) {
-        std::string lowered;
-        lowered.reserve(event.get_name().size());
-        for (char c : event.get_name()) {
-            lowered.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        struct stat st;
+        if (stat(arg.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            paths.push_back(arg);
+            continue;
         }
 
-        if (!hasKickoff && lowered.find("kickoff") != std::string::npos) hasKickoff = true;
-        if (!hasHalftime && lowered.find("halftime") != std::string::npos) hasHalftime = true;
-        if (!hasGoal && lowered.find("goal") != std::string::npos) hasGoal = true;
-        if (!hasFinalWhistle && lowered.find("final whistle") != std::string::npos) hasFinalWhistle = true;
+        DIR* dir = opendir(arg.c_str());
+        if (dir == nullptr) {
+            std::cout << "Error: Could not open directory " << arg << std::endl;
+            continue;
+        }
+        std::vector<std::string> entries;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name[0] == '.' || !endsWith(name, ".json")) continue;
+            std::string path = arg + (arg.back() == '/' ? "" : "/") + name;
+            if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) entries.push_back(path);
+        }
+        closedir(dir);
+        std::sort(entries.begin(), entries.end());
+        paths.insert(paths.end(), entries.begin(), entries.end());
     }
-
-    return hasKickoff && hasHalftime && hasGoal && hasFinalWhistle;
+    return paths;
 }
 
-std::vector<Event> StompProtocol::selectTimelineForSummary(const std::string& canonicalGame,
-                                                           const std::string& targetUser) const {
-    std::vector<Event> chosen;
-    auto gameIt = gameReports.find(canonicalGame);
-    if (gameIt == gameReports.end()) return chosen;
+} // namespace
 
-    auto userIt = gameIt->second.find(targetUser);
-    if (userIt != gameIt->second.end()) {
-        chosen = userIt->second;
-        if (timelineHasRequiredEvents(chosen)) return chosen;
+// Parses every file on reportWorkers, stores the events under _mutex, then
+// encodes the SEND frames in parallel again. Frames are returned grouped by
+// game (in canonical name order) and, within a game, in argument order.
+std::string StompProtocol::processReport(const std::vector<std::string>& words) {
+    std::string user;
+    {
+        stats::CountedLock lock(_mutex);
+        if (currentUsername.empty()) {
+            std::cout << "Error: You must login before performing any other action." << std::endl;
+            return "";
+        }
+        user = currentUsername;
+    }
+    if (words.size() < 2) {
+        std::cout << "Usage: report <path/to/events.json | directory> [more paths...]" << std::endl;
+        return "";
     }
 
-    std::size_t bestScore = 0;
-    for (const auto& ownerEntry : gameIt->second) {
-        const std::string& owner = ownerEntry.first;
-        const std::vector<Event>& events = ownerEntry.second;
-        if (owner == targetUser) continue;
-        if (!timelineHasRequiredEvents(events)) continue;
+    std::vector<std::string> paths = expandReportPaths(words);
+    std::vector<ReportFile> files(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        files[i].path = paths[i];
+    }
 
-        std::size_t score = 0;
-        for (const Event& event : events) {
-            score += eventDetailScore(event);
+    reportWorkers.run(files.size(), [&](std::size_t i) {
+        ReportFile& file = files[i];
+        try {
+            file.parsed = parseEventsFile(file.path);
+            file.canonicalGame = normalizeGameName(file.parsed.team_a_name + "_" + file.parsed.team_b_name);
+        } catch (const std::exception& ex) {
+            file.error = ex.what();
         }
+    });
+
+    std::vector<std::size_t> order(files.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return files[a].canonicalGame < files[b].canonicalGame;
+    });
+
+    bool anyAccepted = false;
+    {
+        stats::CountedLock lock(_mutex);
+        if (currentUsername != user) return "";
+
+        std::set<GameId> clearedGames;
+        for (std::size_t i : order) {
+            ReportFile& file = files[i];
+            std::string prefix = files.size() > 1 ? file.path + ": " : "";
+            if (!file.error.empty()) {
+                std::cout << "Error: " << prefix << file.error << std::endl;
+                continue;
+            }
+            if (file.canonicalGame.empty()) {
+                std::cout << "Error: " << prefix << "Could not determine game name from report." << std::endl;
+                continue;
+            }
+            GameId game = gameIds.intern(file.canonicalGame);
+            if (gameToSubId.count(game) == 0) {
+                std::cout << "Error: " << prefix << "You must join " << resolveDestination(game)
+                          << " before reporting events." << std::endl;
+                continue;
+            }
+
+            file.destination = resolveDestination(game);
+            // Several files for one game (e.g. one per half) replace the
+            // user's timeline together, not one another.
+            if (clearedGames.insert(game).second) {
+                clearTimeline(game, user);
+            }
+            for (Event& event : file.parsed.events) {
+                event.set_event_owner(user);
+                storeEvent(game, event);
+            }
+            if (publishTimestamps) {
+                std::uint64_t& sequence = publishSequences[game];
+                file.firstSequence = sequence + 1;
+                sequence += file.parsed.events.size();
+            }
+            file.accepted = true;
+            anyAccepted = true;
+        }
+    }
+
+    reportWorkers.run(files.size(), [&](std::size_t i) {
+        ReportFile& file = files[i];
+        if (!file.accepted) return;
+        trace::Span span("encode report");
+        const std::vector<Event>& events = file.parsed.events;
+        std::uint64_t first = file.firstSequence;
+        std::size_t size = 0;
+        for (std::size_t e = 0; e < events.size(); ++e) {
+            size += reportFrameSize(file.destination, user, events[e], first == 0 ? 0 : first + e);
+        }
+        file.frames.reserve(size);
+        for (std::size_t e = 0; e < events.size(); ++e) {
+            appendReportFrame(file.frames, file.destination, user, events[e], first == 0 ? 0 : first + e);
+        }
+    });
+
+    std::size_t total = 0;
+    for (const ReportFile& file : files) total += file.frames.size();
+    std::string allFrames;
+    allFrames.reserve(total);
+    for (std::size_t i : order) {
+        allFrames += files[i].frames;
+    }
+
+    if (anyAccepted) {
+        std::cout << "Events reported successfully" << std::endl;
+    }
+    return allFrames;
+}
+
+namespace {
+
+bool parseQueryInt(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < INT_MIN || parsed > INT_MAX) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
 
-        if (score > bestScore) {
-            bestScore = score;
-            chosen = events;
+bool equalsIgnoreCase(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
         }
     }
+    return true;
+}
+
+void appendStatValue(std::ostringstream& out, const char* label, const std::map<std::string, std::string>& updates,
+                     const std::string& key) {
+    auto it = updates.find(key);
+    if (it != updates.end()) out << " " << label << "=" << it->second;
+}
+
+} // namespace
+
+namespace {
 
-    if (!chosen.empty()) return chosen;
+// Value of a decimal header, or 0 if it is not a plain number.
+std::uint64_t decimalHeader(const TextView& value) {
+    TextView text = value.trimmed();
+    if (text.empty()) return 0;
+    std::uint64_t parsed = 0;
+    for (std::size_t i = 0; i < text.size; ++i) {
+        if (text.data[i] < '0' || text.data[i] > '9') return 0;
+        parsed = parsed * 10 + static_cast<std::uint64_t>(text.data[i] - '0');
+    }
+    return parsed;
+}
 
-    if (userIt != gameIt->second.end()) return userIt->second;
+} // namespace
 
-    return chosen;
+void StompProtocol::recordPublish(GameId game, const FrameView& view, const TextView& publishedAt,
+                                  std::uint64_t receivedAt) {
+    std::uint64_t sequence = decimalHeader(view.header("publish-seq"));
+    std::uint64_t timestamp = decimalHeader(publishedAt);
+    if (sequence == 0 || timestamp == 0) return;
+    publishTracker.record(game, view.header("publisher").trimmed().str(), sequence, timestamp, receivedAt);
 }
 
-void StompProtocol::ensureSummaryFile(std::ofstream& outFile,
-                                      const std::string& teamA,
-                                      const std::string& teamB,
-                                      const std::vector<Event>& userEvents) {
-    std::map<std::string, std::string> generalStats;
-    std::map<std::string, std::string> teamAStats;
-    std::map<std::string, std::string> teamBStats;
+namespace {
+
+void printTimer(std::ostream& out, const char* label, const stats::TimerTotals& timer) {
+    out << "  " << label << ": " << timer.count;
+    if (timer.count > 0) {
+        out << ", mean " << timer.totalNanos / timer.count / 1000.0 << " us, max " << timer.maxNanos / 1000.0 << " us";
+    }
+    out << "\n";
+}
+
+} // namespace
+
+// Usage: stats | stats dump <path> [seconds] | stats dump off
+std::string StompProtocol::processStats(const std::vector<std::string>& words) {
+    if (words.size() == 1) {
+        std::string text;
+        {
+            stats::CountedLock lock(_mutex);
+            text = formatStats();
+        }
+        std::cout << text << std::flush;
+        return "";
+    }
+    if (words[1] == "dump" && words.size() == 3 && words[2] == "off") {
+        statsDump.stop();
+        std::cout << "Stats dump stopped" << std::endl;
+        return "";
+    }
+    int seconds = words.size() == 4 ? std::atoi(words[3].c_str()) : 10;
+    if (words[1] != "dump" || words.size() < 3 || words.size() > 4 || seconds <= 0) {
+        std::cout << "Usage: stats [dump <path> [seconds] | dump off]" << std::endl;
+        return "";
+    }
+    std::string path = words[2];
+    statsDump.start(std::chrono::seconds(seconds), [this, path] {
+        std::string text;
+        {
+            stats::CountedLock lock(_mutex);
+            text = formatStats();
+        }
+        replaceFileContents(path, text);
+    });
+    std::cout << "Dumping stats to " << path << " every " << seconds << " s" << std::endl;
+    return "";
+}
 
-    for (const Event& e : userEvents) {
-        for (const auto& entry : e.get_game_updates()) {
-            generalStats[entry.first] = entry.second;
+// Usage: trace start | trace stop | trace dump <path>
+std::string StompProtocol::processTrace(const std::vector<std::string>& words) {
+    if (words.size() == 2 && words[1] == "start") {
+        trace::start();
+        std::cout << "Tracing started" << std::endl;
+    } else if (words.size() == 2 && words[1] == "stop") {
+        trace::stop();
+        std::cout << "Tracing stopped" << std::endl;
+    } else if (words.size() == 3 && words[1] == "dump") {
+        trace::Dump dump = trace::render();
+        if (!replaceFileContents(words[2], dump.json)) {
+            std::cout << "Error: Could not open file " << words[2] << std::endl;
+            return "";
         }
-        for (const auto& entry : e.get_team_a_updates()) {
-            teamAStats[entry.first] = entry.second;
+        std::cout << "Wrote " << dump.spans << " spans to " << words[2];
+        if (dump.dropped > 0) std::cout << " (" << dump.dropped << " older spans were overwritten)";
+        std::cout << std::endl;
+    } else {
+        std::cout << "Usage: trace start | trace stop | trace dump <path>" << std::endl;
+    }
+    return "";
+}
+
+// Caller holds _mutex.
+std::string StompProtocol::formatStats() const {
+    stats::Snapshot snapshot = stats::read();
+    const std::uint64_t* counters = snapshot.counters;
+    std::ostringstream out;
+    out << "Frames received: " << counters[stats::FRAMES_MESSAGE] << " MESSAGE, " << counters[stats::FRAMES_RECEIPT]
+        << " RECEIPT, " << counters[stats::FRAMES_CONNECTED] << " CONNECTED, " << counters[stats::FRAMES_ERROR]
+        << " ERROR, " << counters[stats::FRAMES_OTHER] << " other\n";
+    printTimer(out, "processResponse", snapshot.timers[stats::TIMER_PROCESS_RESPONSE]);
+    out << "Frames sent: " << counters[stats::FRAMES_SENT] << ", send queue " << snapshot.sendQueueDepth << " (max "
+        << snapshot.sendQueueDepthMax << ")\n";
+    printTimer(out, "receipt round trip", snapshot.timers[stats::TIMER_RECEIPT_RTT]);
+    out << "Events stored: " << counters[stats::EVENTS_STORED] << ", " << counters[stats::EVENTS_REPLACED]
+        << " replaced an earlier copy\n";
+    out << "Lock: " << counters[stats::LOCK_ACQUIRED] << " acquisitions, " << counters[stats::LOCK_CONTENDED]
+        << " contended\n";
+    printTimer(out, "lock wait", snapshot.timers[stats::TIMER_LOCK_WAIT]);
+
+    out << "Stored games:" << (gameReports.empty() ? " none" : "") << "\n";
+    for (const auto& gameEntry : gameReports) {
+        std::size_t events = 0;
+        std::size_t bytes = 0;
+        for (const auto& ownerEntry : gameEntry.second) {
+            events += ownerEntry.second.events.size();
+            bytes += ownerEntry.second.memoryUsage();
         }
-        for (const auto& entry : e.get_team_b_updates()) {
-            teamBStats[entry.first] = entry.second;
+        out << "  " << resolveDestination(gameEntry.first) << ": " << gameEntry.second.size() << " reporters, "
+            << events << " events, ~" << (bytes + 1023) / 1024 << " KB\n";
+    }
+    if (!snapshotGames.empty()) out << "  (" << snapshotGames.size() << " games still only in the snapshot)\n";
+
+    publishTracker.report(out, [this](GameId game) { return resolveDestination(game); });
+    return out.str();
+}
+
+void StompProtocol::processQuery(const std::vector<std::string>& words) {
+    const char* usage =
+        "Usage: query <event <word[*]> | key <stat> | time <from> <to>> "
+        "[game=<game>] [user=<user>] [team=<team>] [from=<t>] [to=<t>] [limit=<n>]";
+    if (words.size() < 3) {
+        std::cout << usage << std::endl;
+        return;
+    }
+
+    const std::string& kind = words[1];
+    std::size_t firstFilter = 3;
+    int from = INT_MIN;
+    int to = INT_MAX;
+    if (kind == "time") {
+        if (words.size() < 4 || !parseQueryInt(words[2], from) || !parseQueryInt(words[3], to)) {
+            std::cout << usage << std::endl;
+            return;
         }
+        firstFilter = 4;
+    } else if (kind != "event" && kind != "key") {
+        std::cout << usage << std::endl;
+        return;
     }
 
-    outFile << teamA << " vs " << teamB << "\n";
-    outFile << "Game stats:\n";
+    std::string game, user, team;
+    std::size_t limit = 50;
+    for (std::size_t i = firstFilter; i < words.size(); ++i) {
+        const std::string& word = words[i];
+        if (word.empty()) continue;
+        std::size_t eq = word.find('=');
+        std::string name = word.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : word.substr(eq + 1);
+        int number = 0;
+        if (name == "game" && !value.empty()) {
+            game = normalizeGameName(value);
+        } else if (name == "user" && !value.empty()) {
+            user = value;
+        } else if (name == "team" && !value.empty()) {
+            team = value;
+        } else if (name == "from" && parseQueryInt(value, number)) {
+            from = std::max(from, number);
+        } else if (name == "to" && parseQueryInt(value, number)) {
+            to = std::min(to, number);
+        } else if (name == "limit" && parseQueryInt(value, number) && number > 0) {
+            limit = static_cast<std::size_t>(number);
+        } else {
+            std::cout << "Error: Unknown query filter '" << word << "'" << std::endl;
+            std::cout << usage << std::endl;
+            return;
+        }
+    }
 
-    outFile << "General stats:\n";
-    for (const auto& entry : generalStats) {
-        outFile << entry.first << ": " << entry.second << "\n";
+    // Queries span every game, so snapshot games can no longer stay lazy.
+    while (!snapshotGames.empty()) {
+        materializeSnapshotGame(snapshotGames.begin()->first);
     }
 
-    outFile << teamA << " stats:\n";
-    for (const auto& entry : teamAStats) {
-        outFile << entry.first << ": " << entry.second << "\n";
+    std::vector<const EventIndex::Entry*> hits;
+    if (kind == "event") {
+        std::string token = words[2];
+        bool prefix = !token.empty() && token.back() == '*';
+        if (prefix) token.pop_back();
+        std::vector<std::string> tokens = EventIndex::nameTokens(token);
+        if (tokens.size() != 1) {
+            std::cout << "Error: query event takes a single word, optionally ending in '*'" << std::endl;
+            return;
+        }
+        hits = eventIndex.byNameToken(tokens.front(), prefix);
+    } else if (kind == "key") {
+        hits = eventIndex.byStatKey(words[2]);
+    } else {
+        hits = eventIndex.byTimeRange(from, to);
     }
 
-    outFile << teamB << " stats:\n";
-    for (const auto& entry : teamBStats) {
-        outFile << entry.first << ": " << entry.second << "\n";
+    std::vector<const EventIndex::Entry*> matches;
+    for (const EventIndex::Entry* hit : hits) {
+        const Event& event = hit->event();
+        if (event.get_time() < from || event.get_time() > to) continue;
+        if (!game.empty() && *hit->game != game) continue;
+        if (!user.empty() && *hit->owner != user) continue;
+        if (!team.empty() && !equalsIgnoreCase(event.get_team_a_name(), team) &&
+            !equalsIgnoreCase(event.get_team_b_name(), team)) {
+            continue;
+        }
+        matches.push_back(hit);
     }
 
-    outFile << "Game event reports:\n";
-    for (const Event& e : userEvents) {
-        outFile << e.get_time() << " - " << e.get_name() << ":\n\n";
+    std::size_t shown = std::min(limit, matches.size());
+    auto byGameAndTime = [](const EventIndex::Entry* a, const EventIndex::Entry* b) {
+        if (*a->game != *b->game) return *a->game < *b->game;
+        if (a->event().get_time() != b->event().get_time()) return a->event().get_time() < b->event().get_time();
+        if (*a->owner != *b->owner) return *a->owner < *b->owner;
+        return a->event().get_name() < b->event().get_name();
+    };
+    std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(shown), matches.end(),
+                      byGameAndTime);
 
-        std::string description = e.get_description();
-        while (!description.empty() && (description.back() == '\n' || description.back() == '\r')) {
-            description.pop_back();
+    std::ostringstream out;
+    out << "Found " << matches.size() << " events";
+    if (shown < matches.size()) out << " (showing " << shown << ")";
+    out << "\n";
+    for (std::size_t i = 0; i < shown; ++i) {
+        const EventIndex::Entry& hit = *matches[i];
+        const Event& event = hit.event();
+        out << "  " << resolveDestination(gameIds.find(*hit.game)) << " " << event.get_time() << " "
+            << *hit.owner << ": " << event.get_name();
+        if (kind == "key") {
+            out << " |";
+            appendStatValue(out, "general", event.get_game_updates(), words[2]);
+            if (team.empty() || equalsIgnoreCase(event.get_team_a_name(), team)) {
+                appendStatValue(out, event.get_team_a_name().c_str(), event.get_team_a_updates(), words[2]);
+            }
+            if (team.empty() || equalsIgnoreCase(event.get_team_b_name(), team)) {
+                appendStatValue(out, event.get_team_b_name().c_str(), event.get_team_b_updates(), words[2]);
+            }
         }
-        outFile << description << "\n\n";
+        out << "\n";
     }
+    std::cout << out.str() << std::flush;
 }
 
     std::vector<std::string> StompProtocol::split(const std::string& str, char delimiter) {
@@ -232,9 +665,15 @@ void StompProtocol::ensureSummaryFile(std::ofstream& outFile,
     return tokens;
 }
 std::string StompProtocol::processInput(std::string input) {
-    std::lock_guard<std::mutex> lock(_mutex);
     std::vector<std::string> words = split(input, ' ');
     if (words.empty()) return "";
+    // report parses files without holding _mutex, so it manages the lock itself.
+    if (words[0] == "report") return processReport(words);
+    // stats dump joins a thread that takes _mutex, so it must not hold it.
+    if (words[0] == "stats") return processStats(words);
+    if (words[0] == "trace") return processTrace(words);
+
+    stats::CountedLock lock(_mutex);
 
     std::string command = words[0];
     if (command != "login" && currentUsername == "") {
@@ -254,16 +693,18 @@ std::string StompProtocol::processInput(std::string input) {
         currentUsername = words[2];
         subscriptionCounter = 0;
         receiptCounter = 0;
-        canonicalToSubId.clear();
-        subIdToCanonical.clear();
-        canonicalToDestination.clear();
+        gameToSubId.clear();
+        subscriptionFilters.clear();
+        subIdToGame.clear();
+        gameDestinations.clear();
+        publishSequences.clear();
         std::string frame = "CONNECT\naccept-version:1.2\nhost:stomp.cs.bgu.ac.il\nlogin:" + words[2] + "\npasscode:" + words[3] + "\n\n";
         return frame;
     }
 
     if (command == "join") {
         if (words.size() < 2) {
-            std::cout << "Usage: join <game>" << std::endl;
+            std::cout << "Usage: join <game> [owner=<user,...>] [event=<pattern,...>] [keys=<key,...>]" << std::endl;
             return "";
         }
         std::string rawGame = trim(words[1]);
@@ -272,18 +713,29 @@ std::string StompProtocol::processInput(std::string input) {
             std::cout << "Error: Invalid game name." << std::endl;
             return "";
         }
-        if (canonicalToSubId.count(canonical) != 0) {
-            std::cout << "Error: Already subscribed to " << resolveDestinationForCanonical(canonical) << std::endl;
+        GameId game = gameIds.intern(canonical);
+        if (gameToSubId.count(game) != 0) {
+            std::cout << "Error: Already subscribed to " << resolveDestination(game) << std::endl;
+            return "";
+        }
+        SubscriptionFilter filter;
+        std::string filterError;
+        if (!filter.parse(std::vector<std::string>(words.begin() + 2, words.end()), filterError)) {
+            std::cout << "Error: " << filterError << std::endl;
             return "";
         }
         int subId = subscriptionCounter++;
         int recId = receiptCounter++;
-        std::string destination = rawGame.empty() ? resolveDestinationForCanonical(canonical) : rawGame;
+        std::string destination = rawGame.empty() ? resolveDestination(game) : rawGame;
+        if (!filter.empty()) {
+            subscriptionFilters[game] = filter;
+        }
 
-        subIdToCanonical[subId] = canonical;
-        canonicalToSubId[canonical] = subId;
-        canonicalToDestination[canonical] = destination;
+        subIdToGame[subId] = game;
+        gameToSubId[game] = subId;
+        gameDestinations[game] = destination;
         receiptIdToCommand[recId] = "Joined channel " + destination;
+        if (!filter.empty()) receiptIdToCommand[recId] += " (filter: " + filter.describe() + ")";
 
         std::string frame = "SUBSCRIBE\ndestination:/" + destination + "\nid:" + std::to_string(subId) + "\nreceipt:" + std::to_string(recId) + "\n\n";
         return frame;
@@ -291,21 +743,22 @@ std::string StompProtocol::processInput(std::string input) {
 
     if (command == "exit") {
         if (words.size() > 1) {
-            std::string canonical = normalizeGameName(words[1]);
-            auto it = canonicalToSubId.find(canonical);
-            if (it == canonicalToSubId.end()) {
+            GameId game = gameIds.find(normalizeGameName(words[1]));
+            auto it = gameToSubId.find(game);
+            if (it == gameToSubId.end()) {
                 std::cout << "Error: You are not subscribed to channel " << words[1] << std::endl;
                 return "";
             }
 
             int subId = it->second;
             int recId = receiptCounter++;
-            std::string destination = resolveDestinationForCanonical(canonical);
+            std::string destination = resolveDestination(game);
             receiptIdToCommand[recId] = "Exited channel " + destination;
 
-            canonicalToSubId.erase(it);
-            canonicalToDestination.erase(canonical);
-            subIdToCanonical.erase(subId);
+            gameToSubId.erase(it);
+            subscriptionFilters.erase(game);
+            gameDestinations.erase(game);
+            subIdToGame.erase(subId);
             std::string frame = "UNSUBSCRIBE\nid:" + std::to_string(subId) + "\nreceipt:" + std::to_string(recId) + "\n\n";
             return frame;
         } else {
@@ -313,9 +766,10 @@ std::string StompProtocol::processInput(std::string input) {
             receiptIdToCommand[recId] = "logout";
             shouldTerminate = true;
             currentUsername.clear();
-            subIdToCanonical.clear();
-            canonicalToSubId.clear();
-            canonicalToDestination.clear();
+            subIdToGame.clear();
+            gameToSubId.clear();
+            subscriptionFilters.clear();
+            gameDestinations.clear();
             return "DISCONNECT\nreceipt:" + std::to_string(recId) + "\n\n";
         }
     }
@@ -325,71 +779,24 @@ std::string StompProtocol::processInput(std::string input) {
         receiptIdToCommand[recId] = "logout";
         shouldTerminate = true;
         currentUsername.clear();
-        subIdToCanonical.clear();
-        canonicalToSubId.clear();
-        canonicalToDestination.clear();
+        subIdToGame.clear();
+        gameToSubId.clear();
+        subscriptionFilters.clear();
+        gameDestinations.clear();
         return "DISCONNECT\nreceipt:" + std::to_string(recId) + "\n\n";
     }
-    if (command == "report") {
-        if (words.size() < 2) {
-            std::cout << "Usage: report <path/to/events.json>" << std::endl;
-            return "";
-        }
-
-        names_and_events n_e;
-        try {
-            n_e = parseEventsFile(words[1]);
-        } catch (const std::exception& ex) {
-            std::cout << "Error: " << ex.what() << std::endl;
-            return "";
-        }
-
-        std::string canonicalGame = normalizeGameName(n_e.team_a_name + "_" + n_e.team_b_name);
-        if (canonicalGame.empty()) {
-            std::cout << "Error: Could not determine game name from report." << std::endl;
-            return "";
-        }
-
-        if (canonicalToSubId.count(canonicalGame) == 0) {
-            std::cout << "Error: You must join " << resolveDestinationForCanonical(canonicalGame)
-                      << " before reporting events." << std::endl;
+    if (command == "query") {
+        processQuery(words);
+        return "";
+    }
+    if (command == "timestamps") {
+        if (words.size() != 2 || (words[1] != "on" && words[1] != "off")) {
+            std::cout << "Usage: timestamps on|off" << std::endl;
             return "";
         }
-
-        std::string destination = resolveDestinationForCanonical(canonicalGame);
-        std::string allFrames = "";
-
-        gameReports[canonicalGame][currentUsername].clear();
-        
-        for (const Event& e : n_e.events) {
-            Event localCopy = e;
-            localCopy.set_event_owner(currentUsername);
-            storeEvent(canonicalGame, localCopy);
-            allFrames += "SEND\ndestination:/" + destination + "\n\n";
-            allFrames += "user:" + currentUsername + "\n";
-            allFrames += "team a:" + e.get_team_a_name() + "\n";
-            allFrames += "team b:" + e.get_team_b_name() + "\n";
-            allFrames += "event name:" + e.get_name() + "\n";
-            allFrames += "time:" + std::to_string(e.get_time()) + "\n";
-            allFrames += "general game updates:\n";
-            for (auto const& entry : e.get_game_updates()) {
-                allFrames += "    " + entry.first + ":" + entry.second + "\n";
-            }
-            allFrames += "team a updates:\n";
-            for (auto const& entry : e.get_team_a_updates()) {
-                allFrames += "    " + entry.first + ":" + entry.second + "\n";
-            }
-            
-            allFrames += "team b updates:\n";
-            for (auto const& entry : e.get_team_b_updates()) {
-                allFrames += "    " + entry.first + ":" + entry.second + "\n";
-            }
-            
-            allFrames += "description:\n" + e.get_description() + "\n";
-            allFrames += '\0'; 
-        }
-        std::cout << "Events reported successfully" << std::endl;
-        return allFrames;
+        publishTimestamps = words[1] == "on";
+        std::cout << "Publish timestamps " << (publishTimestamps ? "on" : "off") << std::endl;
+        return "";
     }
     if (command == "summary") {
         if (words.size() < 4) {
@@ -397,90 +804,118 @@ std::string StompProtocol::processInput(std::string input) {
             return "";
         }
 
-        std::string canonical = normalizeGameName(words[1]);
+        GameId game = gameIds.find(normalizeGameName(words[1]));
         std::string targetUser = words[2];
         std::string filePath = words[3];
 
-        std::ofstream outFile(filePath);
-        if (!outFile.is_open()) {
-            std::cout << "Error: Could not open file " << filePath << std::endl;
-            return "";
-        }
-
-        std::vector<Event> timeline = selectTimelineForSummary(canonical, targetUser);
+        materializeSnapshotGame(game);
+        const Timeline* chosen = selectTimelineForSummary(game, targetUser);
 
-        if (timeline.empty()) {
-            outFile << "No events found for user " << targetUser << " in game " << words[1] << "\n";
-            outFile.close();
-            std::cout << "Summary written to " << filePath << std::endl;
+        std::string contents;
+        if (chosen == nullptr || chosen->events.empty()) {
+            contents = "No events found for user " + targetUser + " in game " + words[1] + "\n";
+        } else if (!chosen->isComplete()) {
+            std::cout << "Summary for " << resolveDestination(game)
+                      << " is not ready yet. Waiting for additional events." << std::endl;
             return "";
+        } else {
+            // Sort pointers into the stored timeline instead of a copy of it;
+            // they stay valid because _mutex is held until rendering is done.
+            std::vector<const Event*> timeline;
+            timeline.reserve(chosen->events.size());
+            for (const Event& event : chosen->events) timeline.push_back(&event);
+            std::sort(timeline.begin(), timeline.end(), [](const Event* a, const Event* b) {
+                if (a->get_time() != b->get_time()) return a->get_time() < b->get_time();
+                return a->get_name() < b->get_name();
+            });
+            trace::Span span("summary render");
+            contents = renderSummary(timeline.front()->get_team_a_name(), timeline.front()->get_team_b_name(), *chosen,
+                                     timeline);
         }
 
-        std::sort(timeline.begin(), timeline.end(), [](const Event& a, const Event& b) {
-            if (a.get_time() != b.get_time()) return a.get_time() < b.get_time();
-            return a.get_name() < b.get_name();
-        });
-
-        if (!timelineHasRequiredEvents(timeline)) {
-            outFile.close();
-            std::cout << "Summary for " << resolveDestinationForCanonical(canonical)
-                      << " is not ready yet. Waiting for additional events." << std::endl;
+        trace::Span span("summary write");
+        if (!replaceFileContents(filePath, contents)) {
+            std::cout << "Error: Could not open file " << filePath << std::endl;
             return "";
         }
-
-        ensureSummaryFile(outFile, timeline.front().get_team_a_name(), timeline.front().get_team_b_name(), timeline);
-        outFile.close();
         std::cout << "Summary written to " << filePath << std::endl;
         return "";
     }
     return "";
 }
-void StompProtocol::processResponse(std::string frame) {
-    std::lock_guard<std::mutex> lock(_mutex);
-    std::vector<std::string> lines = split(frame, '\n');
-    if (lines.empty()) return;
+void StompProtocol::markFrameSent(const std::string& frame, std::uint64_t sentAt) {
+    FrameView view(frame);
+    TextView receipt = view.header("receipt");
+    if (receipt.empty()) return;
+    int recId = std::atoi(receipt.str().c_str());
+    stats::CountedLock lock(_mutex);
+    if (receiptIdToCommand.count(recId) != 0) receiptSentAt[recId] = sentAt;
+}
 
-    std::string stompCommand = lines[0];
+void StompProtocol::processResponse(const std::string& frame) {
+    stats::ScopedTimer timer(stats::TIMER_PROCESS_RESPONSE);
+    trace::Span span("processResponse");
+    std::uint64_t receivedAt = monotonicNanos();
+    FrameView view(frame);
+    const TextView& stompCommand = view.command();
+    stats::CountedLock lock(_mutex);
 
-    if (stompCommand == "CONNECTED") {
+    if (stompCommand.equals("MESSAGE")) stats::count(stats::FRAMES_MESSAGE);
+    else if (stompCommand.equals("RECEIPT")) stats::count(stats::FRAMES_RECEIPT);
+    else if (stompCommand.equals("CONNECTED")) stats::count(stats::FRAMES_CONNECTED);
+    else if (stompCommand.equals("ERROR")) stats::count(stats::FRAMES_ERROR);
+    else stats::count(stats::FRAMES_OTHER);
+
+    if (stompCommand.equals("CONNECTED")) {
         std::cout << "Login successful" << std::endl;
     }
-    else if (stompCommand == "RECEIPT") {
-        for (const std::string& rawLine : lines) {
-            if (rawLine.find("receipt-id:") == 0) {
-                int rId = std::stoi(rawLine.substr(11));
-                auto msgIt = receiptIdToCommand.find(rId);
-                if (msgIt != receiptIdToCommand.end()) {
-                    std::cout << msgIt->second << std::endl;
-                    if (msgIt->second == "logout") {
-                        shouldTerminate = true;
-                        currentUsername.clear();
-                        subscriptionCounter = 0;
-                        receiptCounter = 0;
-                        canonicalToSubId.clear();
-                        subIdToCanonical.clear();
-                        canonicalToDestination.clear();
-                    }
-                    receiptIdToCommand.erase(msgIt);
+    else if (stompCommand.equals("RECEIPT")) {
+        TextView receiptId = view.header("receipt-id");
+        if (!receiptId.empty()) {
+            int rId = std::stoi(receiptId.str());
+            auto sentIt = receiptSentAt.find(rId);
+            if (sentIt != receiptSentAt.end()) {
+                stats::recordTime(stats::TIMER_RECEIPT_RTT, receivedAt - sentIt->second);
+                receiptSentAt.erase(sentIt);
+            }
+            auto msgIt = receiptIdToCommand.find(rId);
+            if (msgIt != receiptIdToCommand.end()) {
+                std::cout << msgIt->second << std::endl;
+                if (msgIt->second == "logout") {
+                    shouldTerminate = true;
+                    currentUsername.clear();
+                    subscriptionCounter = 0;
+                    receiptCounter = 0;
+                    gameToSubId.clear();
+                    subscriptionFilters.clear();
+                    subIdToGame.clear();
+                    gameDestinations.clear();
                 }
+                receiptIdToCommand.erase(msgIt);
             }
         }
     }
-    else if (stompCommand == "MESSAGE") {
-        std::string destination;
-        for (const std::string& rawLine : lines) {
-            if (rawLine.find("destination:/") == 0) {
-                destination = trim(rawLine.substr(13));
-                break;
-            }
+    else if (stompCommand.equals("MESSAGE")) {
+        TextView destination;
+        TextView destinationHeader = view.header("destination");
+        if (destinationHeader.startsWith("/", 1)) {
+            destination = destinationHeader.substr(1).trimmed();
         }
 
-        size_t bodyPos = frame.find("\n\n");
-        if (bodyPos != std::string::npos) {
-            std::string body = frame.substr(bodyPos + 2);
-            if (!body.empty() && body.back() == '\0') {
-                body.pop_back();
+        if (view.hasBody()) {
+            GameId game = NO_GAME;
+            if (!destination.empty()) {
+                game = gameIds.resolve(destination.data, destination.size);
+                TextView publishedAt = view.header("publish-ts");
+                if (!publishedAt.empty() && game != NO_GAME) {
+                    recordPublish(game, view, publishedAt, receivedAt);
+                }
+                auto filterIt = subscriptionFilters.find(game);
+                if (filterIt != subscriptionFilters.end() && !filterIt->second.accepts(view.body())) {
+                    return;
+                }
             }
+            std::string body = view.body().str();
 
             std::istringstream stream(body);
             std::string line;
@@ -546,44 +981,131 @@ void StompProtocol::processResponse(std::string frame) {
                 user = "unknown";
             }
             event.set_event_owner(user);
-            std::string canonicalGame = normalizeGameName(destination.empty() ? teamA + "_" + teamB : destination);
-            if (!canonicalGame.empty()) {
-                canonicalToDestination[canonicalGame] = destination.empty() ? canonicalToPretty(canonicalGame) : destination;
-                storeEvent(canonicalGame, event);
+            if (destination.empty()) {
+                std::string canonicalGame = normalizeGameName(teamA + "_" + teamB);
+                if (!canonicalGame.empty()) {
+                    game = gameIds.intern(canonicalGame);
+                    gameDestinations[game] = canonicalToPretty(canonicalGame);
+                }
+            } else if (game != NO_GAME) {
+                // Only the first MESSAGE from a destination (or a respelling) copies it.
+                std::string& stored = gameDestinations[game];
+                if (stored.size() != destination.size ||
+                    std::memcmp(stored.data(), destination.data, destination.size) != 0) {
+                    stored = destination.str();
+                }
+            }
+            if (game != NO_GAME) {
+                storeEvent(game, event);
             }
         }
     }
-    else if (stompCommand == "ERROR") {
+    else if (stompCommand.equals("ERROR")) {
         std::cout << "Error from server: " << frame << std::endl;
         shouldTerminate = true;
         currentUsername.clear();
         subscriptionCounter = 0;
         receiptCounter = 0;
-        canonicalToSubId.clear();
-        subIdToCanonical.clear();
-        canonicalToDestination.clear();
+        gameToSubId.clear();
+        subscriptionFilters.clear();
+        subIdToGame.clear();
+        gameDestinations.clear();
         receiptIdToCommand.clear();
+        receiptSentAt.clear();
     }
 }
 bool StompProtocol::isTerminated() const {
-    std::lock_guard<std::mutex> lock(_mutex);
+    stats::CountedLock lock(_mutex);
     return shouldTerminate;
 }
 
 void StompProtocol::markConnectionClosed() {
-    std::lock_guard<std::mutex> lock(_mutex);
+    stats::CountedLock lock(_mutex);
     shouldTerminate = true;
     currentUsername.clear();
     subscriptionCounter = 0;
     receiptCounter = 0;
-    canonicalToSubId.clear();
-    subIdToCanonical.clear();
-    canonicalToDestination.clear();
+    gameToSubId.clear();
+    subscriptionFilters.clear();
+    subIdToGame.clear();
+    gameDestinations.clear();
     receiptIdToCommand.clear();
+    receiptSentAt.clear();
 }
 
 void StompProtocol::resetAfterSession() {
-    std::lock_guard<std::mutex> lock(_mutex);
+    stats::CountedLock lock(_mutex);
     shouldTerminate = false;
     receiptIdToCommand.clear();
+    receiptSentAt.clear();
+}
+
+bool StompProtocol::openEventLog(const std::string& path) {
+    stats::CountedLock lock(_mutex);
+    eventLogEnabled = false;
+
+    EventLog::ReplayHandler handler;
+    handler.onEvent = [this](const std::string& canonicalGame, const Event& event) {
+        storeEvent(gameIds.intern(canonicalGame), event);
+    };
+    handler.onClearTimeline = [this](const std::string& canonicalGame, const std::string& owner) {
+        clearTimeline(gameIds.intern(canonicalGame), owner);
+    };
+
+    EventLog::ReplayResult replayed;
+    if (!eventLog.open(path, handler, &replayed)) return false;
+    eventLogEnabled = true;
+
+    if (replayed.events > 0) {
+        std::cout << "Restored " << replayed.events << " events from " << path << std::endl;
+    }
+    if (replayed.truncatedTail) {
+        std::cout << "Warning: Discarded an incomplete record at the end of " << path << std::endl;
+    }
+    return true;
+}
+
+void StompProtocol::closeEventLog() {
+    stats::CountedLock lock(_mutex);
+    eventLogEnabled = false;
+    eventLog.close();
+}
+
+bool StompProtocol::loadSnapshot(const std::string& path) {
+    stats::CountedLock lock(_mutex);
+    std::string error;
+    if (!snapshot.open(path, error)) {
+        std::cout << "Error: Could not load snapshot " << path << ": " << error << std::endl;
+        return false;
+    }
+
+    snapshotGames.clear();
+    for (std::size_t i = 0; i < snapshot.gameCount(); ++i) {
+        snapshotGames[gameIds.intern(snapshot.gameName(i))] = i;
+    }
+    std::cout << "Loaded snapshot with " << snapshot.eventCount() << " events from " << path << std::endl;
+    if (snapshotGames.empty()) snapshot.close();
+    return true;
+}
+
+bool StompProtocol::saveSnapshot(const std::string& path) {
+    stats::CountedLock lock(_mutex);
+    while (!snapshotGames.empty()) {
+        materializeSnapshotGame(snapshotGames.begin()->first);
+    }
+
+    EventSnapshotWriter writer;
+    for (const auto& gameEntry : gameReports) {
+        for (const auto& ownerEntry : gameEntry.second) {
+            writer.addTimeline(gameIds.name(gameEntry.first), ownerEntry.first, ownerEntry.second.events);
+        }
+    }
+    if (!writer.write(path)) {
+        std::cout << "Error: Could not write snapshot " << path << std::endl;
+        return false;
+    }
+    if (eventLogEnabled && !eventLog.truncate()) {
+        std::cout << "Warning: Could not truncate the event log after writing " << path << std::endl;
+    }
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "../include/SubscriptionFilter.h"
+#include <cctype>
+#include <cstdint>
+
+namespace {
+
+std::vector<std::string> splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::size_t start = 0;
+    while (start <= value.size()) {
+        std::size_t comma = value.find(',', start);
+        if (comma == std::string::npos) comma = value.size();
+        if (comma > start) items.push_back(value.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+std::string joinList(const std::vector<std::string>& items) {
+    std::string joined;
+    for (const std::string& item : items) {
+        if (!joined.empty()) joined += ',';
+        joined += item;
+    }
+    return joined;
+}
+
+const char USER_KEY[] = "user:";
+const char EVENT_NAME_KEY[] = "event name:";
+const char DESCRIPTION_KEY[] = "description:";
+const char UPDATE_INDENT[] = "    ";
+const std::size_t MAX_REQUIRED_KEYS = 64;
+
+} // namespace
+
+SubscriptionFilter::SubscriptionFilter() : owners(), eventPatterns(), requiredKeys() {}
+
+bool SubscriptionFilter::parse(const std::vector<std::string>& args, std::string& error) {
+    for (const std::string& arg : args) {
+        if (arg.empty()) continue;
+        std::size_t eq = arg.find('=');
+        std::vector<std::string> values = eq == std::string::npos ? std::vector<std::string>() : splitList(arg.substr(eq + 1));
+        if (values.empty()) {
+            error = "Invalid filter '" + arg + "'";
+            return false;
+        }
+
+        std::string key = arg.substr(0, eq);
+        if (key == "owner") {
+            owners.insert(owners.end(), values.begin(), values.end());
+        } else if (key == "event") {
+            for (std::string& pattern : values) {
+                for (char& c : pattern) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                eventPatterns.push_back(pattern);
+            }
+        } else if (key == "keys") {
+            requiredKeys.insert(requiredKeys.end(), values.begin(), values.end());
+            if (requiredKeys.size() > MAX_REQUIRED_KEYS) {
+                error = "At most " + std::to_string(MAX_REQUIRED_KEYS) + " required keys are supported";
+                return false;
+            }
+        } else {
+            error = "Unknown filter '" + key + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SubscriptionFilter::empty() const {
+    return owners.empty() && eventPatterns.empty() && requiredKeys.empty();
+}
+
+std::string SubscriptionFilter::describe() const {
+    std::string text;
+    if (!owners.empty()) text += " owner=" + joinList(owners);
+    if (!eventPatterns.empty()) text += " event=" + joinList(eventPatterns);
+    if (!requiredKeys.empty()) text += " keys=" + joinList(requiredKeys);
+    return text.empty() ? text : text.substr(1);
+}
+
+// Iterative glob with single-star backtracking; text is compared lowercased.
+bool SubscriptionFilter::globMatch(const char* pattern, std::size_t patternLength, const TextView& text) {
+    std::size_t p = 0, t = 0;
+    std::size_t starP = std::string::npos, starT = 0;
+    while (t < text.size) {
+        char c = static_cast<char>(std::tolower(static_cast<unsigned char>(text.data[t])));
+        if (p < patternLength && (pattern[p] == '?' || pattern[p] == c)) {
+            ++p;
+            ++t;
+        } else if (p < patternLength && pattern[p] == '*') {
+            starP = p++;
+            starT = t;
+        } else if (starP != std::string::npos) {
+            p = starP + 1;
+            t = ++starT;
+        } else {
+            return false;
+        }
+    }
+    while (p < patternLength && pattern[p] == '*') ++p;
+    return p == patternLength;
+}
+
+bool SubscriptionFilter::accepts(const TextView& body) const {
+    if (empty()) return true;
+
+    TextView owner;
+    TextView eventName;
+    bool ownerSeen = false;
+    bool nameSeen = false;
+    std::size_t keysFound = 0;
+    std::uint64_t keySeen = 0;
+    bool needKeys = !requiredKeys.empty();
+
+    forEachLine(body, [&](const TextView& line) {
+        if (line.startsWith(UPDATE_INDENT, sizeof(UPDATE_INDENT) - 1)) {
+            if (!needKeys) return true;
+            TextView rest = line.substr(sizeof(UPDATE_INDENT) - 1);
+            const char* colon = static_cast<const char*>(std::memchr(rest.data, ':', rest.size));
+            if (colon == nullptr) return true;
+            TextView key = TextView(rest.data, static_cast<std::size_t>(colon - rest.data)).trimmed();
+            for (std::size_t i = 0; i < requiredKeys.size(); ++i) {
+                std::uint64_t bit = std::uint64_t(1) << i;
+                if (!(keySeen & bit) && key.size == requiredKeys[i].size() &&
+                    std::memcmp(key.data, requiredKeys[i].data(), key.size) == 0) {
+                    keySeen |= bit;
+                    ++keysFound;
+                }
+            }
+            return keysFound < requiredKeys.size();
+        }
+
+        TextView trimmed = line.trimmed();
+        if (!ownerSeen && trimmed.startsWith(USER_KEY, sizeof(USER_KEY) - 1)) {
+            owner = trimmed.substr(sizeof(USER_KEY) - 1).trimmed();
+            ownerSeen = true;
+        } else if (!nameSeen && trimmed.startsWith(EVENT_NAME_KEY, sizeof(EVENT_NAME_KEY) - 1)) {
+            eventName = trimmed.substr(sizeof(EVENT_NAME_KEY) - 1).trimmed();
+            nameSeen = true;
+        } else if (trimmed.equals(DESCRIPTION_KEY)) {
+            return false;
+        }
+        // Once the leading fields are known, only update keys can matter.
+        return needKeys || !(ownerSeen && nameSeen);
+    });
+
+    if (!owners.empty()) {
+        if (owner.empty()) owner = TextView("unknown", 7);
+        bool allowed = false;
+        for (const std::string& candidate : owners) {
+            if (owner.size == candidate.size() && std::memcmp(owner.data, candidate.data(), owner.size) == 0) {
+                allowed = true;
+                break;
+            }
+        }
+        if (!allowed) return false;
+    }
+
+    if (!eventPatterns.empty()) {
+        bool matched = false;
+        for (const std::string& pattern : eventPatterns) {
+            if (globMatch(pattern.data(), pattern.size(), eventName)) {
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) return false;
+    }
+
+    return keysFound == requiredKeys.size();
+}
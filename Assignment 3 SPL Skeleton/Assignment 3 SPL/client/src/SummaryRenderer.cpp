@@ -0,0 +1,99 @@
+#include "../include/SummaryRenderer.h"
+#include <cassert>
+#include <cstring>
+
+namespace {
+
+std::size_t statsSize(const Timeline& timeline, StatSection section) {
+    std::size_t size = 0;
+    for (const auto& entry : timeline.stats[section]) {
+        size += entry.first.size() + 2 + timeline.statValue(section, entry).size() + 1;
+    }
+    return size;
+}
+
+void appendStats(std::string& out, const Timeline& timeline, StatSection section) {
+    for (const auto& entry : timeline.stats[section]) {
+        out.append(entry.first);
+        out.append(": ", 2);
+        out.append(timeline.statValue(section, entry));
+        out.push_back('\n');
+    }
+}
+
+// Formats value into the end of buffer and returns where the digits start.
+char* formatInt(int value, char* end) {
+    unsigned long magnitude = value < 0 ? 0ul - static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
+    char* pos = end;
+    do {
+        *--pos = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) *--pos = '-';
+    return pos;
+}
+
+// Length of the description without trailing newlines.
+std::size_t trimmedLength(const std::string& description) {
+    std::size_t length = description.size();
+    while (length > 0 && (description[length - 1] == '\n' || description[length - 1] == '\r')) {
+        --length;
+    }
+    return length;
+}
+
+const char VS[] = " vs ";
+const char GAME_STATS[] = "\nGame stats:\nGeneral stats:\n";
+const char TEAM_STATS[] = " stats:\n";
+const char EVENT_REPORTS[] = "Game event reports:\n";
+const char TIME_SEPARATOR[] = " - ";
+const char NAME_END[] = ":\n\n";
+const char DESCRIPTION_END[] = "\n\n";
+
+} // namespace
+
+std::string renderSummary(const std::string& teamA, const std::string& teamB, const Timeline& timeline,
+                          const std::vector<const Event*>& events) {
+    char digits[16];
+    char* digitsEnd = digits + sizeof(digits);
+
+    std::size_t size = teamA.size() + sizeof(VS) - 1 + teamB.size() + sizeof(GAME_STATS) - 1 +
+                       statsSize(timeline, STATS_GENERAL) +
+                       teamA.size() + sizeof(TEAM_STATS) - 1 + statsSize(timeline, STATS_TEAM_A) +
+                       teamB.size() + sizeof(TEAM_STATS) - 1 + statsSize(timeline, STATS_TEAM_B) +
+                       sizeof(EVENT_REPORTS) - 1;
+    for (const Event* event : events) {
+        size += static_cast<std::size_t>(digitsEnd - formatInt(event->get_time(), digitsEnd)) +
+                sizeof(TIME_SEPARATOR) - 1 + event->get_name().size() + sizeof(NAME_END) - 1 +
+                trimmedLength(event->get_description()) + sizeof(DESCRIPTION_END) - 1;
+    }
+
+    std::string out;
+    out.reserve(size);
+    out.append(teamA);
+    out.append(VS, sizeof(VS) - 1);
+    out.append(teamB);
+    out.append(GAME_STATS, sizeof(GAME_STATS) - 1);
+    appendStats(out, timeline, STATS_GENERAL);
+    out.append(teamA);
+    out.append(TEAM_STATS, sizeof(TEAM_STATS) - 1);
+    appendStats(out, timeline, STATS_TEAM_A);
+    out.append(teamB);
+    out.append(TEAM_STATS, sizeof(TEAM_STATS) - 1);
+    appendStats(out, timeline, STATS_TEAM_B);
+
+    out.append(EVENT_REPORTS, sizeof(EVENT_REPORTS) - 1);
+    for (const Event* event : events) {
+        const char* time = formatInt(event->get_time(), digitsEnd);
+        out.append(time, static_cast<std::size_t>(digitsEnd - time));
+        out.append(TIME_SEPARATOR, sizeof(TIME_SEPARATOR) - 1);
+        out.append(event->get_name());
+        out.append(NAME_END, sizeof(NAME_END) - 1);
+        const std::string& description = event->get_description();
+        out.append(description.data(), trimmedLength(description));
+        out.append(DESCRIPTION_END, sizeof(DESCRIPTION_END) - 1);
+    }
+
+    assert(out.size() == size);
+    return out;
+}
@@ -0,0 +1,162 @@
+#include "../include/Timeline.h"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+bool containsIgnoreCase(const std::string& text, const char* needle) {
+    std::size_t length = std::strlen(needle);
+    if (text.size() < length) return false;
+    for (std::size_t start = 0; start + length <= text.size(); ++start) {
+        std::size_t i = 0;
+        while (i < length && std::tolower(static_cast<unsigned char>(text[start + i])) == needle[i]) ++i;
+        if (i == length) return true;
+    }
+    return false;
+}
+
+// True if a comes after b in a summary.
+bool reportedAfter(const Event& a, const Event& b) {
+    if (a.get_time() != b.get_time()) return a.get_time() > b.get_time();
+    return a.get_name() > b.get_name();
+}
+
+// Bytes a string keeps outside its own object.
+std::size_t heapBytes(const std::string& text) {
+    return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+// Red-black tree node header: colour, parent, left and right.
+const std::size_t MAP_NODE_OVERHEAD = 32;
+
+std::size_t heapBytes(const std::map<std::string, std::string>& updates) {
+    std::size_t bytes = 0;
+    for (const auto& entry : updates) {
+        bytes += MAP_NODE_OVERHEAD + sizeof(entry) + heapBytes(entry.first) + heapBytes(entry.second);
+    }
+    return bytes;
+}
+
+} // namespace
+
+const std::map<std::string, std::string>& sectionUpdates(const Event& event, StatSection section) {
+    switch (section) {
+    case STATS_TEAM_A:
+        return event.get_team_a_updates();
+    case STATS_TEAM_B:
+        return event.get_team_b_updates();
+    default:
+        return event.get_game_updates();
+    }
+}
+
+unsigned classifyEventName(const std::string& name) {
+    unsigned milestones = 0;
+    if (containsIgnoreCase(name, "kickoff")) milestones |= MILESTONE_KICKOFF;
+    if (containsIgnoreCase(name, "halftime")) milestones |= MILESTONE_HALFTIME;
+    if (containsIgnoreCase(name, "goal")) milestones |= MILESTONE_GOAL;
+    if (containsIgnoreCase(name, "final whistle")) milestones |= MILESTONE_FINAL_WHISTLE;
+    return milestones;
+}
+
+std::size_t eventDetailScore(const Event& event) {
+    std::size_t score = 0;
+    score += event.get_game_updates().size();
+    score += event.get_team_a_updates().size();
+    score += event.get_team_b_updates().size();
+    if (!event.get_description().empty()) score += event.get_description().size();
+    if (!event.get_name().empty()) score += 1;
+    return score;
+}
+
+Timeline::Timeline() : events(), milestones(0), detailScore(0), stats() {}
+
+void Timeline::append(const Event& event) {
+    events.push_back(event);
+    milestones |= classifyEventName(event.get_name());
+    detailScore += eventDetailScore(event);
+    noteStats(events.size() - 1);
+}
+
+void Timeline::replace(std::size_t position, const Event& event) {
+    detailScore -= eventDetailScore(events[position]);
+    events[position] = event;
+    milestones |= classifyEventName(event.get_name());
+    detailScore += eventDetailScore(event);
+
+    // Stats the old event held but the new one lacks fall back to the
+    // next most recent event that has them.
+    for (int s = 0; s < STAT_SECTIONS; ++s) {
+        StatSection section = static_cast<StatSection>(s);
+        const std::map<std::string, std::string>& updates = sectionUpdates(events[position], section);
+        for (auto it = stats[s].begin(); it != stats[s].end();) {
+            if (it->second != position || updates.count(it->first) != 0) {
+                ++it;
+                continue;
+            }
+            std::string key = it->first;
+            ++it;
+            recomputeStat(section, key);
+        }
+    }
+    noteStats(position);
+}
+
+void Timeline::adopt(std::vector<Event>& incoming) {
+    clear();
+    events.swap(incoming);
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        milestones |= classifyEventName(events[i].get_name());
+        detailScore += eventDetailScore(events[i]);
+        noteStats(i);
+    }
+}
+
+void Timeline::clear() {
+    events.clear();
+    milestones = 0;
+    detailScore = 0;
+    for (StatTable& table : stats) table.clear();
+}
+
+std::size_t Timeline::memoryUsage() const {
+    std::size_t bytes = events.capacity() * sizeof(Event);
+    for (const Event& event : events) {
+        bytes += heapBytes(event.get_team_a_name()) + heapBytes(event.get_team_b_name()) + heapBytes(event.get_name());
+        bytes += heapBytes(event.get_description()) + heapBytes(event.get_event_owner());
+        bytes += heapBytes(event.get_game_updates()) + heapBytes(event.get_team_a_updates()) +
+                 heapBytes(event.get_team_b_updates());
+    }
+    for (const StatTable& table : stats) {
+        for (const auto& entry : table) bytes += MAP_NODE_OVERHEAD + sizeof(entry) + heapBytes(entry.first);
+    }
+    return bytes;
+}
+
+void Timeline::noteStats(std::size_t position) {
+    const Event& event = events[position];
+    for (int s = 0; s < STAT_SECTIONS; ++s) {
+        StatTable& table = stats[s];
+        for (const auto& entry : sectionUpdates(event, static_cast<StatSection>(s))) {
+            auto it = table.lower_bound(entry.first);
+            if (it == table.end() || it->first != entry.first) {
+                table.emplace_hint(it, entry.first, position);
+            } else if (it->second != position && reportedAfter(event, events[it->second])) {
+                it->second = position;
+            }
+        }
+    }
+}
+
+void Timeline::recomputeStat(StatSection section, const std::string& key) {
+    std::size_t best = events.size();
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        if (sectionUpdates(events[i], section).count(key) == 0) continue;
+        if (best == events.size() || reportedAfter(events[i], events[best])) best = i;
+    }
+    if (best == events.size()) {
+        stats[section].erase(key);
+    } else {
+        stats[section][key] = best;
+    }
+}
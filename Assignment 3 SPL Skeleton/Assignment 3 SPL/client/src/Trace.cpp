@@ -0,0 +1,148 @@
+#include "../include/Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::uint64_t monotonicNanos() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+namespace trace {
+
+std::atomic<bool> active(false);
+
+namespace {
+
+const std::size_t RING_CAPACITY = 1 << 16;
+
+struct Record {
+    const char* name;
+    std::uint64_t startNanos;
+    std::uint64_t endNanos;
+};
+
+// Only its own thread writes a buffer; the mutex is uncontended except
+// while start() or render() walks the buffers.
+struct ThreadBuffer {
+    ThreadBuffer(unsigned tid, const std::string& name)
+        : bufferMutex(), records(RING_CAPACITY), written(0), tid(tid), threadName(name) {}
+    std::mutex bufferMutex;
+    std::vector<Record> records;
+    std::size_t written;
+    unsigned tid;
+    std::string threadName;
+};
+
+// Buffers are never freed, so spans survive the thread that recorded them.
+struct Registry {
+    Registry() : registryMutex(), buffers(), epochNanos(0) {}
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::uint64_t epochNanos;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+thread_local ThreadBuffer* localBuffer = nullptr;
+thread_local std::string* localName = nullptr;
+
+ThreadBuffer& buffer() {
+    if (localBuffer == nullptr) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.registryMutex);
+        unsigned tid = static_cast<unsigned>(shared.buffers.size()) + 1;
+        std::string name = localName != nullptr ? *localName : "thread " + std::to_string(tid);
+        shared.buffers.emplace_back(new ThreadBuffer(tid, name));
+        localBuffer = shared.buffers.back().get();
+    }
+    return *localBuffer;
+}
+
+void appendMicros(std::string& out, std::uint64_t nanos) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%llu.%03u", static_cast<unsigned long long>(nanos / 1000),
+                               static_cast<unsigned>(nanos % 1000));
+    out.append(text, static_cast<std::size_t>(length));
+}
+
+} // namespace
+
+void start() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.registryMutex);
+    for (const std::unique_ptr<ThreadBuffer>& threadBuffer : shared.buffers) {
+        std::lock_guard<std::mutex> bufferLock(threadBuffer->bufferMutex);
+        threadBuffer->written = 0;
+    }
+    shared.epochNanos = monotonicNanos();
+    active.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+    active.store(false, std::memory_order_relaxed);
+}
+
+void record(const char* name, std::uint64_t startNanos, std::uint64_t endNanos) {
+    ThreadBuffer& threadBuffer = buffer();
+    std::lock_guard<std::mutex> lock(threadBuffer.bufferMutex);
+    Record& slot = threadBuffer.records[threadBuffer.written % RING_CAPACITY];
+    slot.name = name;
+    slot.startNanos = startNanos;
+    slot.endNanos = endNanos;
+    ++threadBuffer.written;
+}
+
+void setThreadName(const std::string& name) {
+    if (localName == nullptr) localName = new std::string();
+    *localName = name;
+    if (localBuffer != nullptr) {
+        std::lock_guard<std::mutex> lock(localBuffer->bufferMutex);
+        localBuffer->threadName = name;
+    }
+}
+
+Dump render() {
+    Dump dump = {std::string(), 0, 0};
+    std::string& out = dump.json;
+    out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.registryMutex);
+    for (const std::unique_ptr<ThreadBuffer>& threadBuffer : shared.buffers) {
+        std::lock_guard<std::mutex> bufferLock(threadBuffer->bufferMutex);
+        std::string tid = std::to_string(threadBuffer->tid);
+        out += first ? "\n" : ",\n";
+        first = false;
+        out += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"" +
+               threadBuffer->threadName + "\"}}";
+
+        std::size_t kept = std::min(threadBuffer->written, RING_CAPACITY);
+        dump.dropped += threadBuffer->written - kept;
+        for (std::size_t i = threadBuffer->written - kept; i < threadBuffer->written; ++i) {
+            const Record& span = threadBuffer->records[i % RING_CAPACITY];
+            // Spans begun before start() are cut off at it.
+            if (span.endNanos < shared.epochNanos) continue;
+            std::uint64_t begin = std::max(span.startNanos, shared.epochNanos);
+            out += ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"name\":\"";
+            out += span.name;
+            out += "\",\"ts\":";
+            appendMicros(out, begin - shared.epochNanos);
+            out += ",\"dur\":";
+            appendMicros(out, span.endNanos - begin);
+            out += "}";
+            ++dump.spans;
+        }
+    }
+    out += "\n]}\n";
+    return dump;
+}
+
+} // namespace trace
@@ -0,0 +1,87 @@
+#include "../include/WorkerPool.h"
+#include "../include/Trace.h"
+
+WorkerPool::WorkerPool(std::size_t threads) :
+    threadCount(threads),
+    workers(),
+    runMutex(),
+    poolMutex(),
+    jobReady(),
+    jobDone(),
+    job(nullptr),
+    jobCount(0),
+    nextIndex(0),
+    activeWorkers(0),
+    generation(0),
+    stopping(false) {
+    if (threadCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 0;
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t WorkerPool::size() const {
+    return threadCount;
+}
+
+void WorkerPool::drain() {
+    std::size_t index;
+    while ((index = nextIndex.fetch_add(1)) < jobCount) {
+        (*job)(index);
+    }
+}
+
+void WorkerPool::run(std::size_t count, const std::function<void(std::size_t)>& task) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> running(runMutex);
+
+    // Threads are started on first use so idle clients do not pay for them.
+    if (workers.size() < threadCount && count > 1) {
+        while (workers.size() < threadCount) {
+            workers.emplace_back(&WorkerPool::workerLoop, this, generation);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        job = &task;
+        jobCount = count;
+        nextIndex = 0;
+        activeWorkers = workers.size();
+        ++generation;
+    }
+    jobReady.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    jobDone.wait(lock, [&] { return activeWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::workerLoop(std::size_t seen) {
+    trace::setThreadName("worker");
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (true) {
+        jobReady.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+
+        lock.unlock();
+        drain();
+        lock.lock();
+
+        if (--activeWorkers == 0) jobDone.notify_one();
+    }
+}
@@ -1,19 +1,27 @@
 #include "../include/event.h"
 #include "../include/json.hpp"
+#include "../include/FileUtil.h"
+#include "../include/Trace.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <map>
 #include <vector>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 using json = nlohmann::json;
 
 Event::Event(std::string team_a_name, std::string team_b_name, std::string name, int time,
              std::map<std::string, std::string> game_updates, std::map<std::string, std::string> team_a_updates,
              std::map<std::string, std::string> team_b_updates, std::string description)
-    : team_a_name(team_a_name), team_b_name(team_b_name), name(name),
-      time(time), game_updates(game_updates), team_a_updates(team_a_updates),
-      team_b_updates(team_b_updates), description(description)
+    : team_a_name(std::move(team_a_name)), team_b_name(std::move(team_b_name)), name(std::move(name)),
+      time(time), game_updates(std::move(game_updates)), team_a_updates(std::move(team_a_updates)),
+      team_b_updates(std::move(team_b_updates)), description(std::move(description)), event_owner()
 {
 }
 Event::Event(const std::string & frame_body) : team_a_name(""), team_b_name(""), name(""), time(0), game_updates(), team_a_updates(), team_b_updates(), description(""), event_owner("")
@@ -88,10 +96,55 @@ const std::string &Event::get_description() const
 {
     return this->description;
 }
-names_and_events parseEventsFile(std::string json_path)
+static bool readFileIntoBuffer(const std::string &json_path, std::string &buffer)
 {
+    int fd = ::open(json_path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        buffer.reserve(static_cast<std::size_t>(st.st_size));
+    char chunk[1 << 16];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) != 0)
+    {
+        // A read interrupted by a signal is retried, not taken as failure.
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+        buffer.append(chunk, static_cast<std::size_t>(n));
+    }
+    ::close(fd);
+    return n == 0;
+}
+
+static json loadEventsJson(const std::string &json_path, EventsFileReader reader)
+{
+    if (reader == EventsFileReader::Auto || reader == EventsFileReader::Mmap)
+    {
+        MappedFile mapped;
+        if (mapped.open(json_path))
+            return json::parse(mapped.data(), mapped.data() + mapped.size());
+        if (reader == EventsFileReader::Mmap)
+            throw std::runtime_error("Could not map " + json_path);
+    }
+    else if (reader == EventsFileReader::Buffer)
+    {
+        std::string buffer;
+        if (!readFileIntoBuffer(json_path, buffer))
+            throw std::runtime_error("Could not read " + json_path);
+        return json::parse(buffer);
+    }
+
     std::ifstream f(json_path);
-    json data = json::parse(f);
+    return json::parse(f);
+}
+
+names_and_events parseEventsFile(std::string json_path, EventsFileReader reader)
+{
+    trace::Span span("parseEventsFile");
+    json data = loadEventsJson(json_path, reader);
 
     std::string team_a_name = data["team a"];
     std::string team_b_name = data["team b"];
@@ -145,9 +198,10 @@ names_and_events parseEventsFile(std::string json_path)
                 team_b_updates[update.key()] = update.value().dump();
         }
         
-        events.push_back(Event(team_a_name, team_b_name, name, time, game_updates, team_a_updates, team_b_updates, description));
+        events.push_back(Event(team_a_name, team_b_name, std::move(name), time, std::move(game_updates),
+                               std::move(team_a_updates), std::move(team_b_updates), std::move(description)));
     }
-    names_and_events events_and_names{team_a_name, team_b_name, events};
+    names_and_events events_and_names{team_a_name, team_b_name, std::move(events)};
 
     return events_and_names;
 }
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+// Writes synthetic events files in the format of data/events1.json, for
+// scale testing parseEventsFile, report and summary. The same options and
+// seed always produce byte-identical files.
+//
+// Usage: EventsGenerator --out DIR [--seed N] [--scale N] [--games N]
+//            [--events N] [--keys N] [--description MIN:MAX] [--reporters N]
+//            [--malformed-files RATIO] [--malformed-events RATIO]
+//
+// Each game gets one file per reporter (DIR/<teamA>_<teamB>_<reporter>.json).
+// Every file carries kickoff, halftime, a goal and final whistle, so
+// summaries are ready. --scale multiplies the number of games.
+
+namespace {
+
+// splitmix64; unlike the <random> distributions its output does not depend
+// on the standard library, so seeds reproduce across builds.
+class Rng {
+public:
+    explicit Rng(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [low, high].
+    int range(int low, int high) {
+        return low + static_cast<int>(next() % static_cast<std::uint64_t>(high - low + 1));
+    }
+
+    bool chance(double ratio) { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0) < ratio; }
+
+private:
+    std::uint64_t state;
+};
+
+struct Options {
+    Options() : out(), seed(1), scale(1), games(4), events(100), keys(6), minDescription(40), maxDescription(300),
+                reporters(1), malformedFiles(0), malformedEvents(0) {}
+    std::string out;
+    std::uint64_t seed;
+    int scale;
+    int games;
+    int events;
+    int keys;
+    int minDescription;
+    int maxDescription;
+    int reporters;
+    double malformedFiles;
+    double malformedEvents;
+};
+
+struct Update {
+    std::string key;
+    std::string value; // already JSON-encoded
+};
+
+struct GeneratedEvent {
+    GeneratedEvent() : name(), time(0), general(), teamA(), teamB(), milestone(false) {}
+    std::string name;
+    int time;
+    std::vector<Update> general;
+    std::vector<Update> teamA;
+    std::vector<Update> teamB;
+    bool milestone;
+};
+
+const char* const COUNTRIES[] = {"Germany", "Japan", "Spain", "Brazil", "Argentina", "France", "Morocco", "Croatia",
+                                 "Portugal", "Netherlands", "England", "Senegal", "Mexico", "Ghana", "Uruguay",
+                                 "Canada"};
+const int COUNTRY_COUNT = sizeof(COUNTRIES) / sizeof(COUNTRIES[0]);
+
+const char* const EVENT_NAMES[] = {"shot on target", "corner", "yellow card", "substitution", "possession change",
+                                   "foul", "offside", "save", "red card", "free kick"};
+const int EVENT_NAME_COUNT = sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]);
+
+const char* const TEAM_KEYS[] = {"possession", "shots", "corners", "fouls", "yellow cards", "offsides", "saves",
+                                 "red cards"};
+const int TEAM_KEY_COUNT = sizeof(TEAM_KEYS) / sizeof(TEAM_KEYS[0]);
+
+const char* const WORDS[] = {"the", "ball", "striker", "keeper", "cross", "box", "header", "crowd", "referee",
+                             "wing", "pass", "brilliant", "chance", "defender", "corner", "pitch", "minute", "shot",
+                             "wide", "post", "goal", "tackle", "midfield", "counter", "pressure", "save", "whistle"};
+const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+const int MATCH_SECONDS = 5400;
+
+std::string teamKey(int index) {
+    return index < TEAM_KEY_COUNT ? TEAM_KEYS[index] : "stat " + std::to_string(index);
+}
+
+std::string quoted(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    out.push_back('"');
+    return out;
+}
+
+std::string teamName(int index) {
+    int round = index / COUNTRY_COUNT;
+    return COUNTRIES[index % COUNTRY_COUNT] + (round == 0 ? std::string() : std::to_string(round + 1));
+}
+
+std::string description(Rng& rng, const Options& options) {
+    int length = rng.range(options.minDescription, options.maxDescription);
+    std::string text;
+    while (static_cast<int>(text.size()) < length) {
+        if (!text.empty()) text.push_back(' ');
+        text += WORDS[rng.range(0, WORD_COUNT - 1)];
+    }
+    text.resize(static_cast<std::size_t>(length));
+    if (!text.empty()) text.back() = '.';
+    return text;
+}
+
+// Scripted events of one game, in time order: kickoff, halftime and the
+// final whistle at fixed times, at least one goal, the rest drawn at random.
+std::vector<GeneratedEvent> scriptGame(Rng& rng, const Options& options) {
+    int total = options.events < 4 ? 4 : options.events;
+    std::vector<int> times;
+    for (int i = 0; i < total - 3; ++i) times.push_back(rng.range(1, MATCH_SECONDS - 1));
+    std::sort(times.begin(), times.end());
+
+    std::vector<GeneratedEvent> events;
+    GeneratedEvent kickoff;
+    kickoff.name = "kickoff";
+    kickoff.general = {{"active", "true"}, {"before halftime", "true"}};
+    kickoff.milestone = true;
+    events.push_back(kickoff);
+
+    int goals[2] = {0, 0};
+    std::map<std::string, int> counters[2];
+    bool halftimeDone = false;
+    bool scored = false;
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        if (!halftimeDone && times[i] >= MATCH_SECONDS / 2) {
+            GeneratedEvent halftime;
+            halftime.name = "halftime";
+            halftime.time = MATCH_SECONDS / 2;
+            halftime.general = {{"before halftime", "false"}};
+            halftime.milestone = true;
+            events.push_back(halftime);
+            halftimeDone = true;
+        }
+
+        GeneratedEvent event;
+        event.time = times[i];
+        int team = rng.range(0, 1);
+        std::vector<Update>& updates = team == 0 ? event.teamA : event.teamB;
+        bool lastChance = !scored && i + 1 == times.size();
+        if (lastChance || rng.chance(0.12)) {
+            event.name = "goal!!!!";
+            event.milestone = true;
+            updates.push_back({"goals", quoted(std::to_string(++goals[team]))});
+            scored = true;
+        } else {
+            event.name = EVENT_NAMES[rng.range(0, EVENT_NAME_COUNT - 1)];
+        }
+        int updateCount = rng.range(0, 3);
+        for (int u = 0; u < updateCount && options.keys > 0; ++u) {
+            std::string key = teamKey(rng.range(0, options.keys - 1));
+            if (key == "possession") {
+                int share = rng.range(30, 70);
+                event.teamA.push_back({key, quoted(std::to_string(share) + "%")});
+                event.teamB.push_back({key, quoted(std::to_string(100 - share) + "%")});
+            } else {
+                updates.push_back({key, std::to_string(++counters[team][key])});
+            }
+        }
+        if (rng.chance(0.05)) event.general.push_back({"weather", quoted(rng.chance(0.5) ? "rain" : "clear")});
+        events.push_back(event);
+    }
+    if (!halftimeDone) {
+        GeneratedEvent halftime;
+        halftime.name = "halftime";
+        halftime.time = MATCH_SECONDS / 2;
+        halftime.general = {{"before halftime", "false"}};
+        halftime.milestone = true;
+        events.push_back(halftime);
+    }
+
+    GeneratedEvent whistle;
+    whistle.name = "final whistle";
+    whistle.time = MATCH_SECONDS;
+    whistle.general = {{"active", "false"}};
+    whistle.milestone = true;
+    events.push_back(whistle);
+    return events;
+}
+
+void writeUpdates(std::string& out, const char* section, const std::vector<Update>& updates, bool last) {
+    out += "            \"";
+    out += section;
+    out += "\": {";
+    for (std::size_t i = 0; i < updates.size(); ++i) {
+        out += i == 0 ? "\n" : ",\n";
+        out += "                " + quoted(updates[i].key) + ": " + updates[i].value;
+    }
+    out += updates.empty() ? "}" : "\n            }";
+    out += last ? "\n" : ",\n";
+}
+
+// The parser accepts these but has to fall back on defaults or dump()
+// non-string values.
+void writeMalformedEvent(std::string& out, Rng& rng, const GeneratedEvent& event) {
+    switch (rng.range(0, 2)) {
+    case 0:
+        out += "            \"event name\": null,\n            \"time\": " + std::to_string(event.time) + ",\n";
+        break;
+    case 1:
+        out += "            \"event name\": " + quoted(event.name) + ",\n";
+        break;
+    default:
+        out += "            \"event name\": " + quoted(event.name) + ",\n            \"time\": null,\n";
+        break;
+    }
+    out += "            \"general game updates\": {\"nested\": {\"value\": [1, 2]}, \"flag\": false},\n";
+    out += "            \"team a updates\": {},\n            \"team b updates\": {},\n";
+    out += "            \"description\": null\n";
+}
+
+// Rejected by parseEventsFile as a whole.
+std::string malformFile(Rng& rng, const std::string& json) {
+    switch (rng.range(0, 2)) {
+    case 0:
+        return json.substr(0, json.size() / 2);
+    case 1: {
+        std::string broken = json;
+        std::size_t pos = broken.find("\"team a\"");
+        broken.replace(pos, 8, "\"team_a\"");
+        return broken;
+    }
+    default: {
+        std::string broken = json;
+        std::size_t pos = broken.find("\"time\": ");
+        if (pos != std::string::npos) broken.insert(pos + 8, "\"soon\", \"was\": ");
+        return broken;
+    }
+    }
+}
+
+std::string renderFile(Rng& rng, const Options& options, const std::string& teamA, const std::string& teamB,
+                       const std::vector<GeneratedEvent>& script, std::size_t& eventCount) {
+    std::string out = "{\n    \"team a\": " + quoted(teamA) + ",\n    \"team b\": " + quoted(teamB) +
+                      ",\n    \"events\": [";
+    bool first = true;
+    for (const GeneratedEvent& event : script) {
+        // Reporters see every milestone and most of the rest.
+        if (!event.milestone && options.reporters > 1 && rng.chance(0.2)) continue;
+        out += first ? "\n        {\n" : ",\n        {\n";
+        first = false;
+        ++eventCount;
+        if (!event.milestone && rng.chance(options.malformedEvents)) {
+            writeMalformedEvent(out, rng, event);
+        } else {
+            out += "            \"event name\": " + quoted(event.name) + ",\n";
+            out += "            \"time\": " + std::to_string(event.time) + ",\n";
+            out += "            \"event owner\": \"\",\n";
+            writeUpdates(out, "general game updates", event.general, false);
+            writeUpdates(out, "team a updates", event.teamA, false);
+            writeUpdates(out, "team b updates", event.teamB, false);
+            out += "            \"description\": " + quoted(description(rng, options)) + "\n";
+        }
+        out += "        }";
+    }
+    out += "\n    ]\n}\n";
+    return out;
+}
+
+bool parseRatio(const char* text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    return *end == '\0' && value >= 0 && value <= 1;
+}
+
+bool parseCount(const char* text, int& value, int minimum) {
+    char* end = nullptr;
+    long parsed = std::strtol(text, &end, 10);
+    if (*end != '\0' || parsed < minimum || parsed > 100000000) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (i + 1 >= argc) return false;
+        const char* value = argv[++i];
+        bool ok = true;
+        if (flag == "--out") {
+            options.out = value;
+        } else if (flag == "--seed") {
+            char* end = nullptr;
+            options.seed = std::strtoull(value, &end, 10);
+            ok = *end == '\0';
+        } else if (flag == "--scale") {
+            ok = parseCount(value, options.scale, 1);
+        } else if (flag == "--games") {
+            ok = parseCount(value, options.games, 1);
+        } else if (flag == "--events") {
+            ok = parseCount(value, options.events, 4);
+        } else if (flag == "--keys") {
+            ok = parseCount(value, options.keys, 0);
+        } else if (flag == "--reporters") {
+            ok = parseCount(value, options.reporters, 1);
+        } else if (flag == "--description") {
+            std::string range = value;
+            std::size_t colon = range.find(':');
+            ok = colon != std::string::npos &&
+                 parseCount(range.substr(0, colon).c_str(), options.minDescription, 0) &&
+                 parseCount(range.substr(colon + 1).c_str(), options.maxDescription, options.minDescription);
+        } else if (flag == "--malformed-files") {
+            ok = parseRatio(value, options.malformedFiles);
+        } else if (flag == "--malformed-events") {
+            ok = parseRatio(value, options.malformedEvents);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid option " << flag << " " << value << std::endl;
+            return false;
+        }
+    }
+    return !options.out.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: EventsGenerator --out DIR [--seed N] [--scale N] [--games N] [--events N] [--keys N]\n"
+                     "           [--description MIN:MAX] [--reporters N] [--malformed-files RATIO]\n"
+                     "           [--malformed-events RATIO]"
+                  << std::endl;
+        return 1;
+    }
+    if (mkdir(options.out.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Could not create " << options.out << std::endl;
+        return 1;
+    }
+
+    Rng rng(options.seed);
+    long long games = static_cast<long long>(options.games) * options.scale;
+    std::size_t files = 0;
+    std::size_t malformed = 0;
+    std::size_t events = 0;
+    std::size_t bytes = 0;
+    for (long long g = 0; g < games; ++g) {
+        std::string teamA = teamName(static_cast<int>(2 * g));
+        std::string teamB = teamName(static_cast<int>(2 * g + 1));
+        std::vector<GeneratedEvent> script = scriptGame(rng, options);
+        for (int r = 0; r < options.reporters; ++r) {
+            std::string json = renderFile(rng, options, teamA, teamB, script, events);
+            if (rng.chance(options.malformedFiles)) {
+                json = malformFile(rng, json);
+                ++malformed;
+            }
+            std::string path = options.out + "/" + teamA + "_" + teamB + "_reporter" + std::to_string(r + 1) + ".json";
+            std::ofstream out(path, std::ios::binary);
+            out.write(json.data(), static_cast<std::streamsize>(json.size()));
+            if (!out) {
+                std::cerr << "Could not write " << path << std::endl;
+                return 1;
+            }
+            ++files;
+            bytes += json.size();
+        }
+    }
+
+    std::cout << "Wrote " << files << " files (" << malformed << " malformed), " << events << " events, " << bytes
+              << " bytes to " << options.out << std::endl;
+    return 0;
+}
@@ -0,0 +1,289 @@
+#include "../include/ConnectionHandler.h"
+#include "../include/LatencyHistogram.h"
+#include "../include/StompFrame.h"
+#include "../include/Trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Drives a STOMP broker (StompServer in tpc or reactor mode) with N
+// subscriber and M publisher connections over K channels and reports
+// delivered messages/sec and end-to-end latency percentiles.
+//
+// Usage: LoadGenerator [--host H] [--port P] [--subscribers N] [--publishers M]
+//            [--channels K] [--rate MSGS_PER_SEC] [--payload BYTES]
+//            [--duration SECONDS] [--warmup SECONDS]
+//
+// Subscriber i listens on channel i % K. The server only accepts SEND from
+// subscribers of a channel, so every publisher also subscribes to all K
+// channels; its copies are drained but not measured. Each body starts with
+// the time the message was due to be sent (so a publisher falling behind
+// its schedule shows up as latency) and a per-publisher sequence number.
+// --rate 0 sends as fast as the connections allow.
+
+namespace {
+
+struct Options {
+    Options() : host("127.0.0.1"), port(7777), subscribers(4), publishers(1), channels(1), rate(1000), payload(256),
+                duration(10), warmup(1) {}
+    std::string host;
+    int port;
+    int subscribers;
+    int publishers;
+    int channels;
+    double rate;
+    int payload;
+    double duration;
+    double warmup;
+};
+
+std::string channelName(int channel) {
+    return "/load" + std::to_string(channel);
+}
+
+// Parses a decimal number at the start of text; 0 if there is none.
+std::uint64_t leadingNumber(const TextView& text) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < text.size && text.data[i] >= '0' && text.data[i] <= '9'; ++i) {
+        value = value * 10 + static_cast<std::uint64_t>(text.data[i] - '0');
+    }
+    return value;
+}
+
+// One broker connection and the thread reading from it.
+class Client {
+public:
+    Client(const Options& options, const std::string& login)
+        : handler(options.host, static_cast<short>(options.port)), login(login), reader(), sendMutex(), histogram(),
+          delivered(0), errors(0), measureFrom(0), measureUntil(0), measuring(false) {}
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // Connects, logs in and subscribes, waiting for the broker to confirm.
+    bool open(const std::vector<int>& channels) {
+        if (!handler.connect()) return false;
+        std::string frame = "CONNECT\naccept-version:1.2\nhost:stomp.cs.bgu.ac.il\nlogin:" + login +
+                            "\npasscode:load\n\n";
+        if (!handler.sendFrameAscii(frame, '\0') || !expect("CONNECTED")) return false;
+        for (int channel : channels) {
+            frame = "SUBSCRIBE\ndestination:" + channelName(channel) + "\nid:" + std::to_string(channel) +
+                    "\nreceipt:" + std::to_string(channel) + "\n\n";
+            if (!handler.sendFrameAscii(frame, '\0') || !expect("RECEIPT")) return false;
+        }
+        return true;
+    }
+
+    // Starts reading; only messages due to be sent within [from, until) count.
+    void start(std::uint64_t from, std::uint64_t until, bool measure) {
+        measureFrom = from;
+        measureUntil = until;
+        measuring = measure;
+        reader = std::thread(&Client::readLoop, this);
+    }
+
+    bool send(const std::string& frame) {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        return handler.sendFrameAscii(frame, '\0');
+    }
+
+    // Disconnects with a receipt; the reader stops when it arrives.
+    void stop() {
+        send("DISCONNECT\nreceipt:bye\n\n");
+        if (reader.joinable()) reader.join();
+    }
+
+    const LatencyHistogram& latencies() const { return histogram; }
+    std::uint64_t deliveredCount() const { return delivered; }
+    std::uint64_t errorCount() const { return errors; }
+
+private:
+    bool expect(const char* command) {
+        std::string frame;
+        if (!handler.getFrameAscii(frame, '\0')) return false;
+        FrameView view(frame);
+        TextView received = view.command().trimmed();
+        if (received.equals(command)) return true;
+        std::cerr << login << ": expected " << command << ", got " << frame << std::endl;
+        return false;
+    }
+
+    void readLoop() {
+        std::string frame;
+        while (true) {
+            frame.clear();
+            if (!handler.getFrameAscii(frame, '\0')) return;
+            std::size_t start = frame.find_first_not_of('\n');
+            if (start == std::string::npos) continue;
+            if (start > 0) frame.erase(0, start);
+
+            FrameView view(frame);
+            if (view.command().equals("MESSAGE")) {
+                std::uint64_t received = monotonicNanos();
+                if (!measuring) continue;
+                // Body: "sent:<ns>\nseq:<n>\n<padding>"
+                TextView body = view.body();
+                if (!body.startsWith("sent:", 5)) continue;
+                std::uint64_t sent = leadingNumber(body.substr(5));
+                if (sent < measureFrom || sent >= measureUntil) continue;
+                histogram.record(received > sent ? received - sent : 0);
+                ++delivered;
+            } else if (view.command().equals("RECEIPT")) {
+                if (view.header("receipt-id").equals("bye")) return;
+            } else if (view.command().equals("ERROR")) {
+                ++errors;
+                std::cerr << login << ": " << frame << std::endl;
+                return;
+            }
+        }
+    }
+
+    ConnectionHandler handler;
+    std::string login;
+    std::thread reader;
+    std::mutex sendMutex;
+    LatencyHistogram histogram;
+    std::uint64_t delivered;
+    std::uint64_t errors;
+    std::uint64_t measureFrom;
+    std::uint64_t measureUntil;
+    bool measuring;
+};
+
+// Sends round-robin over all channels at rate/publishers messages per
+// second until end, on a fixed schedule.
+std::uint64_t publish(Client& client, const Options& options, int publisher, std::uint64_t begin, std::uint64_t end,
+                      std::atomic<bool>& failed) {
+    double perPublisher = options.rate / options.publishers;
+    std::uint64_t interval = perPublisher > 0 ? static_cast<std::uint64_t>(1e9 / perPublisher) : 0;
+    // Stagger publishers so their sends do not line up.
+    std::uint64_t due = begin + (interval * static_cast<std::uint64_t>(publisher)) / options.publishers;
+    std::string padding(static_cast<std::size_t>(options.payload), 'x');
+    std::uint64_t sequence = 0;
+    std::string frame;
+
+    while (!failed) {
+        std::uint64_t now = monotonicNanos();
+        if (interval == 0) due = now;
+        if (due >= end) break;
+        if (due > now) std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+
+        int channel = static_cast<int>(sequence % static_cast<std::uint64_t>(options.channels));
+        frame = "SEND\ndestination:" + channelName(channel) + "\n\nsent:" + std::to_string(due) +
+                "\nseq:" + std::to_string(sequence) + "\n";
+        frame += padding;
+        if (!client.send(frame)) {
+            failed = true;
+            break;
+        }
+        ++sequence;
+        due += interval;
+    }
+    return sequence;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--host") options.host = value;
+        else if (flag == "--port") options.port = std::atoi(value);
+        else if (flag == "--subscribers") options.subscribers = std::atoi(value);
+        else if (flag == "--publishers") options.publishers = std::atoi(value);
+        else if (flag == "--channels") options.channels = std::atoi(value);
+        else if (flag == "--rate") options.rate = std::atof(value);
+        else if (flag == "--payload") options.payload = std::atoi(value);
+        else if (flag == "--duration") options.duration = std::atof(value);
+        else if (flag == "--warmup") options.warmup = std::atof(value);
+        else return false;
+    }
+    return argc % 2 == 1 && options.port > 0 && options.subscribers >= 0 && options.publishers > 0 &&
+           options.channels > 0 && options.rate >= 0 && options.payload >= 0 && options.duration > 0 &&
+           options.warmup >= 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: LoadGenerator [--host H] [--port P] [--subscribers N] [--publishers M] [--channels K]\n"
+                     "           [--rate MSGS_PER_SEC] [--payload BYTES] [--duration SECONDS] [--warmup SECONDS]"
+                  << std::endl;
+        return 1;
+    }
+
+    // Distinct logins per run, since the broker rejects a user logged in twice.
+    std::string prefix = "load" + std::to_string(monotonicNanos() % 1000000) + "-";
+    std::vector<std::unique_ptr<Client>> subscribers;
+    std::vector<std::unique_ptr<Client>> publishers;
+    std::vector<int> allChannels;
+    for (int c = 0; c < options.channels; ++c) allChannels.push_back(c);
+
+    for (int i = 0; i < options.subscribers; ++i) {
+        subscribers.emplace_back(new Client(options, prefix + "sub" + std::to_string(i)));
+        if (!subscribers.back()->open(std::vector<int>(1, i % options.channels))) {
+            std::cerr << "Subscriber " << i << " could not connect" << std::endl;
+            return 1;
+        }
+    }
+    for (int i = 0; i < options.publishers; ++i) {
+        publishers.emplace_back(new Client(options, prefix + "pub" + std::to_string(i)));
+        if (!publishers.back()->open(allChannels)) {
+            std::cerr << "Publisher " << i << " could not connect" << std::endl;
+            return 1;
+        }
+    }
+
+    std::uint64_t begin = monotonicNanos() + 100000000ull;
+    std::uint64_t measureFrom = begin + static_cast<std::uint64_t>(options.warmup * 1e9);
+    std::uint64_t end = measureFrom + static_cast<std::uint64_t>(options.duration * 1e9);
+    for (auto& client : subscribers) client->start(measureFrom, end, true);
+    for (auto& client : publishers) client->start(measureFrom, end, false);
+
+    std::atomic<bool> failed(false);
+    std::vector<std::uint64_t> sent(publishers.size(), 0);
+    std::vector<std::thread> senders;
+    for (std::size_t i = 0; i < publishers.size(); ++i) {
+        senders.emplace_back([&, i] {
+            sent[i] = publish(*publishers[i], options, static_cast<int>(i), begin, end, failed);
+        });
+    }
+    for (std::thread& sender : senders) sender.join();
+
+    // Let in-flight messages arrive before disconnecting.
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    for (auto& client : publishers) client->stop();
+    for (auto& client : subscribers) client->stop();
+
+    LatencyHistogram latencies;
+    std::uint64_t delivered = 0;
+    std::uint64_t errors = 0;
+    for (auto& client : subscribers) {
+        latencies.merge(client->latencies());
+        delivered += client->deliveredCount();
+        errors += client->errorCount();
+    }
+    for (auto& client : publishers) errors += client->errorCount();
+    std::uint64_t totalSent = 0;
+    for (std::uint64_t count : sent) totalSent += count;
+
+    std::cout << "connections: " << options.subscribers << " subscribers, " << options.publishers
+              << " publishers, " << options.channels << " channels" << std::endl;
+    std::cout << "sent: " << totalSent << " messages (including warmup)" << std::endl;
+    std::cout << "delivered: " << delivered << " messages, " << delivered / options.duration << " msgs/sec"
+              << std::endl;
+    std::cout << "latency us: p50 " << latencies.percentile(50) / 1000.0 << ", p99 "
+              << latencies.percentile(99) / 1000.0 << ", p999 " << latencies.percentile(99.9) / 1000.0 << ", max "
+              << latencies.max() / 1000.0 << std::endl;
+    if (errors > 0 || failed) {
+        std::cout << "errors: " << errors << (failed ? ", a publisher connection failed" : "") << std::endl;
+        return 1;
+    }
+    return 0;
+}
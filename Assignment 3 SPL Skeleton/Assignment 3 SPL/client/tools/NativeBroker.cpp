@@ -0,0 +1,66 @@
+#include "../include/EpollBroker.h"
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Native STOMP broker with the Java server's wire protocol and login rules
+// (users are kept in memory, there is no SQL server), for head-to-head runs
+// with LoadGenerator against StompServer.
+//
+// Usage: NativeBroker [--port P] [--threads N]
+//
+// --threads is the number of epoll reactors, one per core by default. Runs
+// until SIGINT or SIGTERM.
+
+namespace {
+
+struct Options {
+    Options() : port(7777), threads(static_cast<int>(std::thread::hardware_concurrency())) {}
+    int port;
+    int threads;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--port") options.port = std::atoi(value);
+        else if (flag == "--threads") options.threads = std::atoi(value);
+        else return false;
+    }
+    if (options.threads <= 0) options.threads = 1;
+    return argc % 2 == 1 && options.port > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: NativeBroker [--port P] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    // Blocked before the reactors start so they inherit the mask and the
+    // signals reach sigwait below.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    EpollBroker broker(options.threads);
+    if (broker.start(options.port) == 0) {
+        std::cerr << "Could not listen on port " << options.port << std::endl;
+        return 1;
+    }
+    std::cout << "NativeBroker listening on port " << options.port << " with " << options.threads << " reactor(s)"
+              << std::endl;
+
+    int received = 0;
+    sigwait(&signals, &received);
+    broker.stop();
+    return 0;
+}
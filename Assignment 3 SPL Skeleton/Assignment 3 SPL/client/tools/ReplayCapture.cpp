@@ -0,0 +1,115 @@
+#include "../include/ClientStats.h"
+#include "../include/FrameCapture.h"
+#include "../include/LatencyHistogram.h"
+#include "../include/StompProtocol.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Feeds a capture written by `StompWCIClient --capture <path>` straight into
+// StompProtocol::processResponse, with no socket, and reports frames/sec
+// and per-frame processing time.
+//
+// Usage: ReplayCapture <capture> [--paced] [--speed X] [--repeat N]
+//
+// By default frames are replayed back to back. --paced keeps the recorded
+// gaps between frames (divided by --speed). --repeat replays the capture N
+// times into the same protocol, so later passes replace the events stored
+// by the first one, as a client receiving the same reports again would.
+// The protocol's own messages are discarded.
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    Options() : path(), paced(false), speed(1), repeat(1) {}
+    std::string path;
+    bool paced;
+    double speed;
+    int repeat;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--paced") options.paced = true;
+        else if (arg == "--speed" && i + 1 < argc) options.speed = std::atof(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc) options.repeat = std::atoi(argv[++i]);
+        else if (options.path.empty() && arg.compare(0, 2, "--") != 0) options.path = arg;
+        else return false;
+    }
+    return !options.path.empty() && options.speed > 0 && options.repeat > 0;
+}
+
+std::uint64_t nanosSince(Clock::time_point start) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: ReplayCapture <capture> [--paced] [--speed X] [--repeat N]" << std::endl;
+        return 1;
+    }
+
+    FrameCaptureReader reader;
+    std::string error;
+    if (!reader.open(options.path, error)) {
+        std::cerr << "Could not open " << options.path << ": " << error << std::endl;
+        return 1;
+    }
+
+    StompProtocol protocol;
+    LatencyHistogram perFrame;
+    std::uint64_t frames = 0;
+    std::uint64_t bytes = 0;
+    std::string frame;
+    std::streambuf* savedOut = std::cout.rdbuf(nullptr);
+
+    Clock::time_point start = Clock::now();
+    for (int pass = 0; pass < options.repeat; ++pass) {
+        reader.rewind();
+        Clock::time_point passStart = Clock::now();
+        FrameCaptureReader::Frame captured;
+        while (reader.next(captured)) {
+            if (options.paced) {
+                std::uint64_t due = static_cast<std::uint64_t>(captured.offsetNanos / options.speed);
+                std::uint64_t elapsed = nanosSince(passStart);
+                if (due > elapsed) std::this_thread::sleep_for(std::chrono::nanoseconds(due - elapsed));
+            }
+            frame.assign(captured.data, captured.size);
+            // The client skips empty frames (heart-beats) the same way.
+            if (frame.empty()) continue;
+            std::uint64_t before = monotonicNanos();
+            protocol.processResponse(frame);
+            perFrame.record(monotonicNanos() - before);
+            ++frames;
+            bytes += frame.size();
+        }
+    }
+    double seconds = nanosSince(start) / 1e9;
+
+    std::cout.rdbuf(savedOut);
+    std::cout.clear();
+    if (reader.truncated()) std::cout << "warning: the capture ends in an incomplete record" << std::endl;
+
+    stats::Snapshot counters = stats::read();
+    std::cout << "frames: " << frames << " (" << counters.counters[stats::FRAMES_MESSAGE] << " MESSAGE, "
+              << counters.counters[stats::FRAMES_RECEIPT] << " RECEIPT, " << counters.counters[stats::FRAMES_OTHER] +
+                     counters.counters[stats::FRAMES_CONNECTED] + counters.counters[stats::FRAMES_ERROR]
+              << " other), " << bytes << " bytes in " << seconds << " s" << std::endl;
+    if (seconds > 0) {
+        std::cout << "throughput: " << frames / seconds << " frames/sec, " << bytes / seconds / (1 << 20) << " MB/sec"
+                  << std::endl;
+    }
+    std::cout << "processResponse us: p50 " << perFrame.percentile(50) / 1000.0 << ", p99 "
+              << perFrame.percentile(99) / 1000.0 << ", max " << perFrame.max() / 1000.0 << std::endl;
+    std::cout << "events stored: " << counters.counters[stats::EVENTS_STORED] << ", "
+              << counters.counters[stats::EVENTS_REPLACED] << " replaced" << std::endl;
+    return 0;
+}
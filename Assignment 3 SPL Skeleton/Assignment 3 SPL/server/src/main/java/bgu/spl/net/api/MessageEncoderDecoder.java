@@ -1,5 +1,9 @@
 package bgu.spl.net.api;
 
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.List;
+
 public interface MessageEncoderDecoder<T> {
 
     /**
@@ -11,6 +15,23 @@ public interface MessageEncoderDecoder<T> {
      */
     T decodeNextByte(byte nextByte);
 
+    /**
+     * decodes a whole chunk of input at once
+     *
+     * @param chunk the bytes from its position to its limit; all of them are
+     * consumed, and an unfinished message is kept for the next call
+     * @return the messages completed by this chunk, in order (possibly none).
+     * The default goes through decodeNextByte one byte at a time.
+     */
+    default List<T> decode(ByteBuffer chunk) {
+        List<T> messages = new ArrayList<>();
+        while (chunk.hasRemaining()) {
+            T message = decodeNextByte(chunk.get());
+            if (message != null) messages.add(message);
+        }
+        return messages;
+    }
+
     /**
      * encodes the given message to bytes array
      *
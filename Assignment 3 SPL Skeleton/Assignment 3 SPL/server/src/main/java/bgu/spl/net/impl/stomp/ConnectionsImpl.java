@@ -4,15 +4,20 @@ import bgu.spl.net.srv.ConnectionHandler;
 import bgu.spl.net.srv.Connections;
 
 import java.io.IOException;
-import java.util.HashMap;
-import java.util.Map;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
 import java.util.concurrent.ConcurrentHashMap;
 import java.util.concurrent.atomic.AtomicInteger;
 
 public class ConnectionsImpl<T> implements Connections<T> {
 
+    private static final String MESSAGE_HEAD = "MESSAGE\nsubscription:";
+    private static final Subscriber[] NO_SUBSCRIBERS = new Subscriber[0];
+
     private final ConcurrentHashMap<Integer, ConnectionHandler<T>> connectedHandlers = new ConcurrentHashMap<>();
-    private final ConcurrentHashMap<String, ConcurrentHashMap<Integer, String>> channelSubscribers = new ConcurrentHashMap<>();
+    // Copy-on-write: an array is never changed once published, subscribe and
+    // unsubscribe swap in a new one, so publishing just walks the current one.
+    private final ConcurrentHashMap<String, Subscriber[]> channelSubscribers = new ConcurrentHashMap<>();
     private final ConcurrentHashMap<Integer, ConcurrentHashMap<String, String>> clientSubscriptions = new ConcurrentHashMap<>();
 
     private final ConcurrentHashMap<String, String> users = new ConcurrentHashMap<>();
@@ -31,9 +36,15 @@ public class ConnectionsImpl<T> implements Connections<T> {
 
     @Override
     public void send(String channel, T msg) {
-        Map<Integer, String> subscribers = getChannelSubscribersSnapshot(channel);
-        for (Integer subscriberId : subscribers.keySet()) {
-            send(subscriberId, msg);
+        for (Subscriber subscriber : subscribersOf(channel)) {
+            send(subscriber.connectionId, msg);
+        }
+    }
+
+    @Override
+    public void sendMessage(String channel, byte[] tail) {
+        for (Subscriber subscriber : subscribersOf(channel)) {
+            subscriber.handler.sendEncoded(subscriber.messageHead, tail);
         }
     }
 
@@ -95,18 +106,23 @@ public class ConnectionsImpl<T> implements Connections<T> {
     public boolean subscribe(String channel, int connectionId, String subscriptionId) {
         if (channel == null || subscriptionId == null) return false;
 
+        ConnectionHandler<T> handler = connectedHandlers.get(connectionId);
+        if (handler == null) return false;
+
         ConcurrentHashMap<String, String> userSubscriptions =
                 clientSubscriptions.computeIfAbsent(connectionId, key -> new ConcurrentHashMap<>());
-        ConcurrentHashMap<Integer, String> channelSubscriptions =
-                channelSubscribers.computeIfAbsent(channel, key -> new ConcurrentHashMap<>());
 
+        // One subscription per channel and connection.
+        if (userSubscriptions.containsValue(channel)) return false;
         if (userSubscriptions.putIfAbsent(subscriptionId, channel) != null) return false;
 
-        if (channelSubscriptions.putIfAbsent(connectionId, subscriptionId) != null) {
-            userSubscriptions.remove(subscriptionId);
-            return false;
-        }
-
+        Subscriber subscriber = new Subscriber(connectionId, handler, subscriptionId);
+        channelSubscribers.compute(channel, (key, current) -> {
+            if (current == null) return new Subscriber[] {subscriber};
+            Subscriber[] updated = Arrays.copyOf(current, current.length + 1);
+            updated[current.length] = subscriber;
+            return updated;
+        });
         return true;
     }
 
@@ -123,25 +139,43 @@ public class ConnectionsImpl<T> implements Connections<T> {
     }
 
     private void removeSubscriberFromChannel(String channel, int connectionId) {
-        ConcurrentHashMap<Integer, String> subscribers = channelSubscribers.get(channel);
-        if (subscribers != null) {
-            subscribers.remove(connectionId);
-            if (subscribers.isEmpty()) {
-                channelSubscribers.compute(channel, (key, current) -> (current == subscribers && current.isEmpty()) ? null : current);
-            }
-        }
+        // Returning null drops the channel once its last subscriber leaves.
+        channelSubscribers.computeIfPresent(channel, (key, current) -> {
+            int index = 0;
+            while (index < current.length && current[index].connectionId != connectionId) index++;
+            if (index == current.length) return current;
+            if (current.length == 1) return null;
+
+            Subscriber[] updated = new Subscriber[current.length - 1];
+            System.arraycopy(current, 0, updated, 0, index);
+            System.arraycopy(current, index + 1, updated, index, updated.length - index);
+            return updated;
+        });
     }
 
     @Override
     public boolean isSubscribed(int connectionId, String channel) {
-        ConcurrentHashMap<Integer, String> subscribers = channelSubscribers.get(channel);
-        return subscribers != null && subscribers.containsKey(connectionId);
+        ConcurrentHashMap<String, String> userSubscriptions = clientSubscriptions.get(connectionId);
+        return userSubscriptions != null && userSubscriptions.containsValue(channel);
     }
 
-    @Override
-    public Map<Integer, String> getChannelSubscribersSnapshot(String channel) {
-        ConcurrentHashMap<Integer, String> subscribers = channelSubscribers.get(channel);
-        return (subscribers == null || subscribers.isEmpty()) ? new HashMap<>() : new HashMap<>(subscribers);
+    private Subscriber[] subscribersOf(String channel) {
+        Subscriber[] subscribers = channelSubscribers.get(channel);
+        return subscribers == null ? NO_SUBSCRIBERS : subscribers;
+    }
+
+    // One entry of a channel's subscriber array. The MESSAGE head is encoded
+    // here, once per subscription, instead of on every publish.
+    private static final class Subscriber {
+        final int connectionId;
+        final ConnectionHandler<?> handler;
+        final byte[] messageHead;
+
+        Subscriber(int connectionId, ConnectionHandler<?> handler, String subscriptionId) {
+            this.connectionId = connectionId;
+            this.handler = handler;
+            this.messageHead = (MESSAGE_HEAD + subscriptionId).getBytes(StandardCharsets.UTF_8);
+        }
     }
 
     private void closeQuietly(ConnectionHandler<T> handler) {
@@ -2,46 +2,89 @@ package bgu.spl.net.impl.stomp;
 
 import bgu.spl.net.api.MessageEncoderDecoder;
 
+import java.nio.ByteBuffer;
 import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+import java.util.logging.Level;
+import java.util.logging.Logger;
 
 public class StompMessageEncoderDecoder implements MessageEncoderDecoder<String> {
 
+    // Frames are logged at FINE, which is off unless logging is configured for it.
+    private static final Logger LOG = Logger.getLogger(StompMessageEncoderDecoder.class.getName());
+
     private byte[] buffer = new byte[1 << 10];
     private int bufferLength = 0;
 
     @Override
     public String decodeNextByte(byte nextByte) {
         if (nextByte == '\0') {
-            String result = popString();
-            System.out.println("[DECODER] Got complete message: " + result.replace("\n", "\\n"));
+            String result = frame(0, bufferLength);
+            bufferLength = 0;
             return result;
         }
         pushByte(nextByte);
         return null;
     }
 
+    // Copies the chunk in with one bulk get and scans it for NULs, instead of
+    // a call per byte.
+    @Override
+    public List<String> decode(ByteBuffer chunk) {
+        int scanFrom = bufferLength;
+        int length = chunk.remaining();
+        ensureCapacity(bufferLength + length);
+        chunk.get(buffer, bufferLength, length);
+        bufferLength += length;
+
+        List<String> messages = Collections.emptyList();
+        int start = 0;
+        for (int i = scanFrom; i < bufferLength; i++) {
+            if (buffer[i] != '\0') continue;
+            if (messages.isEmpty()) messages = new ArrayList<>();
+            messages.add(frame(start, i));
+            start = i + 1;
+        }
+
+        // Keep the unfinished frame at the front for the next chunk.
+        if (start > 0) {
+            System.arraycopy(buffer, start, buffer, 0, bufferLength - start);
+            bufferLength -= start;
+        }
+        return messages;
+    }
+
     @Override
     public byte[] encode(String message) {
+        return encodeFrame(message);
+    }
+
+    // UTF-8 bytes of a frame, or of the tail of one, with the NUL terminator.
+    public static byte[] encodeFrame(String message) {
         if (message == null) message = "";
         if (!message.endsWith("\0")) message += "\0";
         return message.getBytes(StandardCharsets.UTF_8);
     }
 
     private void pushByte(byte nextByte) {
-        ensureCapacity();
+        ensureCapacity(bufferLength + 1);
         buffer[bufferLength++] = nextByte;
     }
 
-    private String popString() {
-        String result = new String(buffer, 0, bufferLength, StandardCharsets.UTF_8);
-        bufferLength = 0;
+    private String frame(int start, int end) {
+        String result = new String(buffer, start, end - start, StandardCharsets.UTF_8);
+        if (LOG.isLoggable(Level.FINE)) {
+            LOG.fine("[DECODER] Got complete message: " + result.replace("\n", "\\n"));
+        }
         return result;
     }
 
-    private void ensureCapacity() {
-        if (bufferLength >= buffer.length) {
-            buffer = Arrays.copyOf(buffer, bufferLength * 2);
+    private void ensureCapacity(int needed) {
+        if (needed > buffer.length) {
+            buffer = Arrays.copyOf(buffer, Math.max(needed, buffer.length * 2));
         }
     }
 }
@@ -148,23 +148,35 @@ public class StompMessagingProtocolImpl implements StompMessagingProtocol<String
 
         String payload = frame.body == null ? "" : frame.body;
         int messageId = connections.nextMessageId();
-        Map<Integer, String> subscribers = connections.getChannelSubscribersSnapshot(destination);
-
-        for (Map.Entry<Integer, String> entry : subscribers.entrySet()) {
-            String message =
-                    "MESSAGE\n" +
-                    "destination:" + destination + "\n" +
-                    "subscription:" + entry.getValue() + "\n" +
-                    "message-id:" + messageId + "\n\n" +
-                    payload;
-            connections.send(entry.getKey(), message);
-        }
+        // Everything after the subscription header is the same for every
+        // subscriber, so it is encoded once and shared.
+        String tail =
+                "\ndestination:" + destination + "\n" +
+                "message-id:" + messageId + "\n" +
+                forwardedHeaders(frame) + "\n" +
+                payload;
+        connections.sendMessage(destination, StompMessageEncoderDecoder.encodeFrame(tail));
 
         Database.getInstance().trackFileUpload(username, "unknown-file", destination);
 
         maybeSendReceipt(frame);
     }
 
+    // Application headers of a SEND (e.g. publish-ts / publish-seq) are
+    // passed on to every MESSAGE; the ones the server sets itself are not.
+    private static String forwardedHeaders(Frame frame) {
+        StringBuilder sb = new StringBuilder();
+        for (Map.Entry<String, String> header : frame.headers.entrySet()) {
+            String name = header.getKey();
+            if (name.equals("destination") || name.equals("receipt") || name.equals("subscription")
+                    || name.equals("message-id")) {
+                continue;
+            }
+            sb.append(name).append(':').append(header.getValue()).append('\n');
+        }
+        return sb.toString();
+    }
+
     private void maybeSendReceipt(Frame frame) {
         String receipt = receiptHeader(frame);
         if (receipt != null) {
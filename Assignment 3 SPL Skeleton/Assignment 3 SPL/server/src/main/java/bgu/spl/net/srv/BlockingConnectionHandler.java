@@ -7,9 +7,12 @@ import java.io.BufferedInputStream;
 import java.io.BufferedOutputStream;
 import java.io.IOException;
 import java.net.Socket;
+import java.nio.ByteBuffer;
 
 public class BlockingConnectionHandler<T> implements Runnable, ConnectionHandler<T> {
 
+    private static final int READ_CHUNK_SIZE = 1 << 13;
+
     private final StompMessagingProtocol<T> protocol;
     private final MessageEncoderDecoder<T> encdec;
     private final Socket sock;
@@ -43,10 +46,11 @@ public class BlockingConnectionHandler<T> implements Runnable, ConnectionHandler
 
             protocol.start(connectionId, connections);
 
+            byte[] chunk = new byte[READ_CHUNK_SIZE];
             int read;
-            while (connected && !protocol.shouldTerminate() && (read = in.read()) >= 0) {
-                T nextMessage = encdec.decodeNextByte((byte) read);
-                if (nextMessage != null) {
+            while (connected && !protocol.shouldTerminate() && (read = in.read(chunk)) >= 0) {
+                for (T nextMessage : encdec.decode(ByteBuffer.wrap(chunk, 0, read))) {
+                    if (protocol.shouldTerminate()) break;
                     protocol.process(nextMessage);
                 }
             }
@@ -84,4 +88,26 @@ public class BlockingConnectionHandler<T> implements Runnable, ConnectionHandler
             }
         }
     }
+
+    @Override
+    public void sendEncoded(byte[] head, byte[] tail) {
+        if (!connected) return;
+
+        synchronized (writeLock) {
+            if (!connected || out == null) return;
+
+            try {
+                out.write(head);
+                out.write(tail);
+                out.flush();
+            } catch (IOException e) {
+                connected = false;
+                try {
+                    sock.close();
+                } catch (IOException ignored) {
+                }
+                connections.disconnect(connectionId);
+            }
+        }
+    }
 }
\ No newline at end of file
@@ -19,4 +19,10 @@ public interface ConnectionHandler<T> extends Closeable {
 
     void send(T msg);
 
+    /**
+     * Sends a message that is already encoded, as head followed by tail.
+     * tail is shared by every recipient of a fan-out and must not be modified.
+     */
+    void sendEncoded(byte[] head, byte[] tail);
+
 }
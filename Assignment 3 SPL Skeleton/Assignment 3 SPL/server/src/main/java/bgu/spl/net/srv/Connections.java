@@ -1,13 +1,18 @@
 package bgu.spl.net.srv;
 
-import java.util.Map;
-
 public interface Connections<T> {
 
     boolean send(int connectionId, T msg);
 
     void send(String channel, T msg);
 
+    /**
+     * Sends a MESSAGE to every subscriber of channel. Only the
+     * "MESSAGE\nsubscription:" head and the id are encoded per subscriber; tail
+     * is the rest of the frame, encoded once (NUL included) and shared by all.
+     */
+    void sendMessage(String channel, byte[] tail);
+
     void disconnect(int connectionId);
 
     boolean subscribe(String channel, int connectionId, String subscriptionId);
@@ -18,8 +23,6 @@ public interface Connections<T> {
 
     int nextMessageId();
 
-    Map<Integer, String> getChannelSubscribersSnapshot(String channel);
-
     enum LoginResult {
         SUCCESS,
         WRONG_PASSWORD,
@@ -7,12 +7,14 @@ import java.io.IOException;
 import java.nio.ByteBuffer;
 import java.nio.channels.SelectionKey;
 import java.nio.channels.SocketChannel;
+import java.util.Arrays;
 import java.util.Queue;
 import java.util.concurrent.ConcurrentLinkedQueue;
 
 public class NonBlockingConnectionHandler<T> implements ConnectionHandler<T> {
 
     private static final int BUFFER_ALLOCATION_SIZE = 1 << 13;
+    private static final int MAX_GATHER = 64;
     private static final ConcurrentLinkedQueue<ByteBuffer> BUFFER_POOL = new ConcurrentLinkedQueue<>();
 
     private final StompMessagingProtocol<T> protocol;
@@ -24,7 +26,10 @@ public class NonBlockingConnectionHandler<T> implements ConnectionHandler<T> {
     private final Connections<T> connections;
     private final int connectionId;
 
+    // Held while adding to writeQueue, so a message's buffers stay adjacent.
     private final Object encodeLock = new Object();
+    // Buffers for one gathering write; used by the selector thread only.
+    private final ByteBuffer[] gather = new ByteBuffer[MAX_GATHER];
 
     public NonBlockingConnectionHandler(MessageEncoderDecoder<T> reader,
                                         StompMessagingProtocol<T> protocol,
@@ -63,14 +68,11 @@ public class NonBlockingConnectionHandler<T> implements ConnectionHandler<T> {
         buf.flip();
         return () -> {
             try {
-                while (buf.hasRemaining()) {
-                    T nextMessage = encdec.decodeNextByte(buf.get());
-                    if (nextMessage != null) {
-                        protocol.process(nextMessage);
-                        if (protocol.shouldTerminate() && writeQueue.isEmpty()) {
-                            connections.disconnect(connectionId);
-                            return;
-                        }
+                for (T nextMessage : encdec.decode(buf)) {
+                    protocol.process(nextMessage);
+                    if (protocol.shouldTerminate() && writeQueue.isEmpty()) {
+                        connections.disconnect(connectionId);
+                        return;
                     }
                 }
             } finally {
@@ -86,18 +88,29 @@ public class NonBlockingConnectionHandler<T> implements ConnectionHandler<T> {
 
     public void continueWrite() {
         while (!writeQueue.isEmpty()) {
-            try {
-                ByteBuffer top = writeQueue.peek();
-                if (top == null) break;
-
-                chan.write(top);
-                if (top.hasRemaining()) return;
+            // One gathering write for as many queued buffers as fit in gather.
+            int count = 0;
+            long offered = 0;
+            for (ByteBuffer buffer : writeQueue) {
+                gather[count++] = buffer;
+                offered += buffer.remaining();
+                if (count == gather.length) break;
+            }
 
-                writeQueue.poll();
+            long written;
+            try {
+                written = chan.write(gather, 0, count);
             } catch (IOException ex) {
                 connections.disconnect(connectionId);
                 return;
+            } finally {
+                Arrays.fill(gather, 0, count, null);
             }
+
+            for (ByteBuffer top = writeQueue.peek(); top != null && !top.hasRemaining(); top = writeQueue.peek()) {
+                writeQueue.poll();
+            }
+            if (written < offered) return;
         }
 
         if (writeQueue.isEmpty()) {
@@ -113,12 +126,20 @@ public class NonBlockingConnectionHandler<T> implements ConnectionHandler<T> {
     public void send(T msg) {
         if (msg == null || isClosed()) return;
 
-        byte[] bytes;
         synchronized (encodeLock) {
-            bytes = encdec.encode(msg);
+            writeQueue.add(ByteBuffer.wrap(encdec.encode(msg)));
         }
+        reactor.updateInterestedOps(chan, SelectionKey.OP_READ | SelectionKey.OP_WRITE);
+    }
 
-        writeQueue.add(ByteBuffer.wrap(bytes));
+    @Override
+    public void sendEncoded(byte[] head, byte[] tail) {
+        if (isClosed()) return;
+
+        synchronized (encodeLock) {
+            writeQueue.add(ByteBuffer.wrap(head));
+            writeQueue.add(ByteBuffer.wrap(tail));
+        }
         reactor.updateInterestedOps(chan, SelectionKey.OP_READ | SelectionKey.OP_WRITE);
     }
 
@@ -0,0 +1,705 @@
+#include "../client/bench/AllocCounter.h"
+#include "../client/bench/BenchFixtures.h"
+#include "../client/bench/BenchHarness.h"
+#include "../client/include/json.hpp"
+#include "ConnectionHandler.h"
+#include "EventLog.h"
+#include "LoopbackBroker.h"
+#include "StompFrame.h"
+#include "StompProtocol.h"
+#include "SummaryRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Correctness scenarios for the client protocol layer, then a performance
+// gate: each perf case's time and heap allocations per operation are
+// compared with perf_baseline.json and a regression beyond the tolerance
+// fails the run.
+//
+// Usage: run_tests [--baseline path] [--update-baseline] [--no-perf]
+//                  [--time-tolerance percent] [--alloc-tolerance percent]
+//
+// Run from tests/ (paths to client data are relative to it). Allocation
+// counts are deterministic, so their tolerance is tight; times depend on
+// the machine, so the checked-in baseline should be refreshed with
+// --update-baseline when the reference machine changes.
+
+namespace {
+
+const std::string DATA_DIR = "../client/data/";
+const std::string EXPECTED_SUMMARY = "../client/summary.txt";
+
+int failures = 0;
+
+#define CHECK(condition)                                                                              \
+    do {                                                                                              \
+        if (!(condition)) {                                                                           \
+            ++failures;                                                                               \
+            std::cerr << "  FAILED " << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; \
+        }                                                                                             \
+    } while (0)
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+std::string tempPath(const std::string& name) {
+    return "/tmp/stomp_tests_" + std::to_string(getpid()) + "_" + name;
+}
+
+// Collects std::cout (the protocol's user-facing messages) for its lifetime.
+class CapturedOutput {
+public:
+    CapturedOutput() : captured(), saved(std::cout.rdbuf(captured.rdbuf())) {}
+    ~CapturedOutput() { std::cout.rdbuf(saved); }
+    CapturedOutput(const CapturedOutput&) = delete;
+    CapturedOutput& operator=(const CapturedOutput&) = delete;
+
+    bool contains(const std::string& text) const { return captured.str().find(text) != std::string::npos; }
+    void clear() { captured.str(""); }
+
+private:
+    std::ostringstream captured;
+    std::streambuf* saved;
+};
+
+// In-memory stand-in for the server and the sockets: frames returned by
+// processInput go straight to the broker, and its replies (CONNECTED,
+// RECEIPT, relayed MESSAGEs) straight into the recipients' processResponse.
+class MemoryBroker {
+public:
+    MemoryBroker() : subscriptions(), nextMessageId(0) {}
+
+    // Runs one command line of client, as StompClient would.
+    void input(StompProtocol& client, const std::string& line) {
+        std::string frames = client.processInput(line);
+        std::size_t start = 0;
+        while (start < frames.size()) {
+            std::size_t end = frames.find('\0', start);
+            if (end == std::string::npos) end = frames.size();
+            handle(client, frames.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+
+private:
+    struct Subscription {
+        StompProtocol* client;
+        std::string id;
+    };
+
+    void handle(StompProtocol& client, const std::string& frame) {
+        FrameView view(frame);
+        const TextView& command = view.command();
+        if (command.equals("CONNECT")) {
+            client.processResponse("CONNECTED\nversion:1.2\n\n");
+        } else if (command.equals("SUBSCRIBE")) {
+            Subscription subscription = {&client, view.header("id").str()};
+            subscriptions[view.header("destination").str()].push_back(subscription);
+        } else if (command.equals("UNSUBSCRIBE")) {
+            std::string id = view.header("id").str();
+            for (auto& entry : subscriptions) {
+                std::vector<Subscription>& list = entry.second;
+                list.erase(std::remove_if(list.begin(), list.end(), [&](const Subscription& s) {
+                    return s.client == &client && s.id == id;
+                }), list.end());
+            }
+        } else if (command.equals("SEND")) {
+            relay(view);
+        }
+        TextView receipt = view.header("receipt");
+        if (!receipt.empty()) client.processResponse("RECEIPT\nreceipt-id:" + receipt.str() + "\n\n");
+    }
+
+    // MESSAGE to every subscriber, with the SEND's own headers passed on.
+    void relay(const FrameView& send) {
+        std::string destination = send.header("destination").str();
+        std::string forwarded;
+        for (const char* name : {"publisher", "publish-seq", "publish-ts"}) {
+            TextView value = send.header(name);
+            if (!value.empty()) forwarded += std::string(name) + ":" + value.str() + "\n";
+        }
+        std::string body = send.body().str();
+        ++nextMessageId;
+        for (const Subscription& subscription : subscriptions[destination]) {
+            subscription.client->processResponse("MESSAGE\ndestination:" + destination + "\nsubscription:" +
+                                                 subscription.id + "\nmessage-id:" +
+                                                 std::to_string(nextMessageId) + "\n" + forwarded + "\n" + body);
+        }
+    }
+
+    std::map<std::string, std::vector<Subscription>> subscriptions;
+    int nextMessageId;
+};
+
+// A client on a real socket to the in-process broker, driven from the test's
+// own thread: input sends a command's frames, readUntil feeds replies into
+// processResponse until one of the given command arrives. There is no reader
+// thread: LoopbackBroker queues outbound frames, so input can send a whole
+// report while the relayed MESSAGEs pile up unread.
+class SocketClient {
+public:
+    explicit SocketClient(LoopbackBroker& broker) : protocol(), handler("127.0.0.1", 0) {
+        handler.adopt(broker.connectPair());
+    }
+
+    void input(const std::string& line) {
+        std::string frames = protocol.processInput(line);
+        std::size_t start = 0;
+        while (start < frames.size()) {
+            std::size_t end = frames.find('\0', start);
+            if (end == std::string::npos) end = frames.size();
+            handler.sendFrameAscii(frames.substr(start, end - start), '\0');
+            start = end + 1;
+        }
+    }
+
+    bool readUntil(const std::string& command) {
+        std::string frame;
+        while (true) {
+            frame.clear();
+            if (!handler.getFrameAscii(frame, '\0')) return false;
+            protocol.processResponse(frame);
+            if (frame.compare(0, command.size() + 1, command + "\n") == 0) return true;
+        }
+    }
+
+    StompProtocol protocol;
+
+private:
+    ConnectionHandler handler;
+};
+
+// --- correctness scenarios ---
+
+void testLoginJoinReportSummary() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol alice;
+    StompProtocol bob;
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    broker.input(bob, "login 127.0.0.1:7777 bob pass");
+    CHECK(output.contains("Login successful"));
+    broker.input(alice, "join Germany_Japan");
+    broker.input(bob, "join Germany_Japan");
+    CHECK(output.contains("Joined channel Germany_Japan"));
+
+    broker.input(alice, "report " + DATA_DIR + "events1.json");
+    CHECK(output.contains("Events reported successfully"));
+
+    // bob builds the summary from the relayed MESSAGEs, alice from her own store.
+    std::string fromBob = tempPath("bob_summary.txt");
+    std::string fromAlice = tempPath("alice_summary.txt");
+    broker.input(bob, "summary Germany_Japan alice " + fromBob);
+    // An existing summary is replaced with its permissions kept.
+    std::ofstream(fromAlice) << "old summary";
+    CHECK(chmod(fromAlice.c_str(), 0600) == 0);
+    broker.input(alice, "summary Germany_Japan alice " + fromAlice);
+    std::string expected = readFile(EXPECTED_SUMMARY);
+    CHECK(!expected.empty());
+    CHECK(readFile(fromBob) == expected);
+    CHECK(readFile(fromAlice) == expected);
+    struct stat st;
+    CHECK(stat(fromAlice.c_str(), &st) == 0 && (st.st_mode & 0777) == 0600);
+    std::remove(fromBob.c_str());
+    std::remove(fromAlice.c_str());
+}
+
+// Same flow over sockets through LoopbackBroker, which follows the Java
+// server's frames rather than MemoryBroker's shortcuts.
+void testOverLoopbackBroker() {
+    CapturedOutput output;
+    LoopbackBroker broker;
+    SocketClient alice(broker);
+    SocketClient bob(broker);
+    alice.input("login 127.0.0.1:7777 alice pass");
+    CHECK(alice.readUntil("CONNECTED"));
+    bob.input("login 127.0.0.1:7777 bob pass");
+    CHECK(bob.readUntil("CONNECTED"));
+    alice.input("join Germany_Japan");
+    CHECK(alice.readUntil("RECEIPT"));
+    bob.input("join Germany_Japan");
+    CHECK(bob.readUntil("RECEIPT"));
+
+    // Resending the same report replaces alice's timeline each time; the
+    // relayed MESSAGEs add up to more than a socket buffer before anyone
+    // reads them.
+    for (int i = 0; i < 100; ++i) alice.input("report " + DATA_DIR + "events1.json");
+    // The broker handles alice's frames in order, so once her UNSUBSCRIBE is
+    // acknowledged every report has been relayed to bob.
+    alice.input("exit Germany_Japan");
+    CHECK(alice.readUntil("RECEIPT"));
+    bob.input("join Spain_Japan");
+    CHECK(bob.readUntil("RECEIPT"));
+
+    std::string path = tempPath("loopback_summary.txt");
+    bob.input("summary Germany_Japan alice " + path);
+    CHECK(readFile(path) == readFile(EXPECTED_SUMMARY));
+    std::remove(path.c_str());
+
+    output.clear();
+    alice.input("login 127.0.0.1:7777 alice wrong");
+    CHECK(output.contains("already logged in"));
+    SocketClient impostor(broker);
+    impostor.input("login 127.0.0.1:7777 alice wrong");
+    CHECK(impostor.readUntil("ERROR"));
+    CHECK(output.contains("Wrong password"));
+
+    // adopt takes TCP sockets only; a socketpair stays with the caller.
+    int pair[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    ConnectionHandler handler("127.0.0.1", 0);
+    CHECK(!handler.adopt(pair[0]));
+    close(pair[0]);
+    close(pair[1]);
+}
+
+void testSummaryWaitsForMilestones() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol alice;
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    broker.input(alice, "join Germany_Japan");
+    broker.input(alice, "report " + DATA_DIR + "events1_partial.json");
+    std::string path = tempPath("partial_summary.txt");
+    broker.input(alice, "summary Germany_Japan alice " + path);
+    CHECK(output.contains("is not ready yet"));
+    CHECK(readFile(path).empty());
+    std::remove(path.c_str());
+}
+
+void testCommandsNeedLogin() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol alice;
+    broker.input(alice, "join Germany_Japan");
+    CHECK(output.contains("You must login"));
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    output.clear();
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    CHECK(output.contains("already logged in"));
+}
+
+void testExitAndLogout() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol alice;
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    broker.input(alice, "join Germany_Japan");
+    broker.input(alice, "exit Germany_Japan");
+    CHECK(output.contains("Exited channel Germany_Japan"));
+    output.clear();
+    broker.input(alice, "exit Germany_Japan");
+    CHECK(output.contains("not subscribed"));
+    CHECK(!alice.isTerminated());
+    broker.input(alice, "logout");
+    CHECK(output.contains("logout"));
+    CHECK(alice.isTerminated());
+}
+
+void testServerErrorEndsSession() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol alice;
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    alice.processResponse("ERROR\nmessage:Wrong password\n\n");
+    CHECK(output.contains("Error from server"));
+    CHECK(alice.isTerminated());
+    output.clear();
+    broker.input(alice, "join Germany_Japan");
+    CHECK(output.contains("You must login"));
+}
+
+// MESSAGE the server relays for user's report of name on game ("Team_Team"),
+// as client processes it without a reader thread.
+void relayReport(StompProtocol& client, const std::string& game, const std::string& user, const std::string& name,
+                 int time, const std::map<std::string, std::string>& general,
+                 const std::map<std::string, std::string>& teamA, const std::map<std::string, std::string>& teamB,
+                 const std::string& description = "nothing to report") {
+    std::size_t underscore = game.find('_');
+    Event event(game.substr(0, underscore), game.substr(underscore + 1), name, time, general, teamA, teamB,
+                description);
+    std::string frame;
+    appendReportFrame(frame, game, user, event);
+    frame.pop_back();
+    frame.replace(0, 4, "MESSAGE\nsubscription:0\nmessage-id:" + std::to_string(time));
+    client.processResponse(frame);
+}
+
+// Filtered MESSAGEs are dropped before they are parsed, so they never reach
+// the store that summaries and queries read.
+void testSubscriptionFilters() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol bob;
+    broker.input(bob, "login 127.0.0.1:7777 bob pass");
+    broker.input(bob, "join Germany_Japan owner=alice,unknown");
+    CHECK(output.contains("Joined channel Germany_Japan (filter: owner=alice,unknown)"));
+    broker.input(bob, "join Spain_Japan event=GOAL*,?ick*");
+    broker.input(bob, "join Brazil_Japan keys=weather,goals,possession");
+
+    // Owners are matched exactly; a report without a user line is "unknown".
+    std::map<std::string, std::string> none;
+    relayReport(bob, "Germany_Japan", "alice", "kickoff", 0, none, none, none);
+    relayReport(bob, "Germany_Japan", "dave", "goal!!!!", 10, none, none, none);
+    relayReport(bob, "Germany_Japan", "", "halftime", 20, none, none, none);
+    relayReport(bob, "Germany_Japan", "alicia", "final whistle", 30, none, none, none);
+
+    // The whole name must match a pattern, in any case; '?' takes exactly one character.
+    relayReport(bob, "Spain_Japan", "alice", "kickoff", 0, none, none, none);
+    relayReport(bob, "Spain_Japan", "alice", "goal!!!!", 10, none, none, none);
+    relayReport(bob, "Spain_Japan", "alice", "Goal by Spain", 20, none, none, none);
+    relayReport(bob, "Spain_Japan", "alice", "ickoff", 30, none, none, none);
+    relayReport(bob, "Spain_Japan", "alice", "own goal", 40, none, none, none);
+    relayReport(bob, "Spain_Japan", "alice", "halftime", 50, none, none, none);
+
+    // Every key is needed, from any of the three sections; the description is not an update.
+    std::map<std::string, std::string> weather = {{"weather", "rain"}};
+    std::map<std::string, std::string> goals = {{"goals", "1"}};
+    std::map<std::string, std::string> goalsAndWeather = {{"goals", "1"}, {"weather", "rain"}};
+    std::map<std::string, std::string> possession = {{"possession", "60%"}};
+    relayReport(bob, "Brazil_Japan", "alice", "rain delay", 10, weather, goals, possession);
+    relayReport(bob, "Brazil_Japan", "alice", "second goal", 20, none, goalsAndWeather, possession);
+    relayReport(bob, "Brazil_Japan", "alice", "third goal", 30, weather, goals, none, "\n    possession: 50%");
+    relayReport(bob, "Brazil_Japan", "alice", "corner", 40, weather, none, possession);
+
+    output.clear();
+    broker.input(bob, "query time 0 100 game=Germany_Japan");
+    broker.input(bob, "query time 0 100 game=Spain_Japan");
+    broker.input(bob, "query time 0 100 game=Brazil_Japan");
+    CHECK(output.contains("Found 2 events\n"
+                          "  Germany_Japan 0 alice: kickoff\n"
+                          "  Germany_Japan 20 unknown: halftime\n"
+                          "Found 3 events\n"
+                          "  Spain_Japan 0 alice: kickoff\n"
+                          "  Spain_Japan 10 alice: goal!!!!\n"
+                          "  Spain_Japan 20 alice: Goal by Spain\n"
+                          "Found 2 events\n"
+                          "  Brazil_Japan 10 alice: rain delay\n"
+                          "  Brazil_Japan 20 alice: second goal\n"));
+}
+
+// Each report clears alice's timeline and her own relayed MESSAGEs replace
+// its events, so the index retires slots until it compacts, with bob's
+// events live throughout; queries must still see exactly the live events.
+void testQueryIndexUpdates() {
+    CapturedOutput output;
+    MemoryBroker broker;
+    StompProtocol alice;
+    broker.input(alice, "login 127.0.0.1:7777 alice pass");
+    broker.input(alice, "join Germany_Japan");
+    std::map<std::string, std::string> none;
+    relayReport(alice, "Germany_Japan", "bob", "goal!!!!", 300, none, {{"goals", "1"}}, none);
+    relayReport(alice, "Germany_Japan", "bob", "goalkeeper save", 400, none, none, none);
+    relayReport(alice, "Germany_Japan", "bob", "own goal", 5000, none, none, none);
+
+    for (int i = 0; i < 300; ++i) broker.input(alice, "report " + DATA_DIR + "events1.json");
+    broker.input(alice, "report " + DATA_DIR + "events1_partial.json");
+    // The same (time, name) again replaces the event, and its keys with it.
+    relayReport(alice, "Germany_Japan", "bob", "goal!!!!", 300, none, {{"assists", "1"}}, none);
+    // Leaving the channel keeps what was stored.
+    broker.input(alice, "exit Germany_Japan");
+
+    output.clear();
+    broker.input(alice, "query event goal*");
+    CHECK(output.contains("Found 4 events\n"
+                          "  Germany_Japan 300 bob: goal!!!!\n"
+                          "  Germany_Japan 400 bob: goalkeeper save\n"
+                          "  Germany_Japan 1980 alice: goal!!!!\n"
+                          "  Germany_Japan 5000 bob: own goal\n"));
+    output.clear();
+    broker.input(alice, "query key goals");
+    CHECK(output.contains("Found 1 events\n"
+                          "  Germany_Japan 1980 alice: goal!!!! | Germany=1\n"));
+    output.clear();
+    broker.input(alice, "query key assists");
+    CHECK(output.contains("Found 1 events\n"
+                          "  Germany_Japan 300 bob: goal!!!! | Germany=1\n"));
+    output.clear();
+    broker.input(alice, "query time 0 100000");
+    CHECK(output.contains("Found 5 events\n"
+                          "  Germany_Japan 0 alice: kickoff\n"));
+    output.clear();
+    broker.input(alice, "query time 0 100000 from=100 to=1980");
+    CHECK(output.contains("Found 3 events\n"
+                          "  Germany_Japan 300 bob: goal!!!!\n"
+                          "  Germany_Japan 400 bob: goalkeeper save\n"
+                          "  Germany_Japan 1980 alice: goal!!!!\n"));
+}
+
+// Writes a log of three events and returns the offsets where each record starts.
+std::vector<long> writeThreeEventLog(const std::string& path) {
+    std::remove(path.c_str());
+    EventLog log;
+    EventLog::ReplayHandler none;
+    log.open(path, none);
+    std::vector<long> starts;
+    for (int i = 0; i < 3; ++i) {
+        starts.push_back(static_cast<long>(readFile(path).size()));
+        std::map<std::string, std::string> updates;
+        Event event("germany", "japan", "goal", i, updates, updates, updates, "minute " + std::to_string(i));
+        event.set_event_owner("alice");
+        log.appendEvent("germany_japan", event);
+        log.flush();
+    }
+    log.close();
+    return starts;
+}
+
+void testEventLogRecovery() {
+    CapturedOutput output;
+    std::string path = tempPath("events.log");
+    std::size_t replayed = 0;
+    EventLog::ReplayHandler counter;
+    counter.onEvent = [&](const std::string&, const Event&) { ++replayed; };
+
+    // A record cut short by a crash is dropped and logging carries on.
+    std::vector<long> starts = writeThreeEventLog(path);
+    CHECK(truncate(path.c_str(), static_cast<off_t>(readFile(path).size() - 3)) == 0);
+    EventLog torn;
+    EventLog::ReplayResult result;
+    CHECK(torn.open(path, counter, &result));
+    CHECK(result.truncatedTail && !result.damaged && result.events == 2);
+    torn.close();
+    CHECK(static_cast<long>(readFile(path).size()) == starts[2]);
+
+    // A bad checksum in the middle refuses the log and leaves the file alone.
+    writeThreeEventLog(path);
+    std::string contents = readFile(path);
+    contents[static_cast<std::size_t>(starts[1]) + 4] ^= 0x5a;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    replayed = 0;
+    EventLog damaged;
+    CHECK(!damaged.open(path, counter, &result));
+    CHECK(result.damaged && replayed == 1);
+    CHECK(result.unreadBytes == contents.size() - static_cast<std::size_t>(starts[1]));
+    CHECK(output.contains("is damaged at byte"));
+    CHECK(readFile(path) == contents);
+    std::remove(path.c_str());
+}
+
+// --- performance gate ---
+
+struct Measurement {
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// Best of a few samples of body(n); allocations come from one more pass.
+Measurement measure(std::size_t ops, const std::function<void(std::size_t)>& body) {
+    body(ops); // warm-up
+    double best = 0;
+    for (int sample = 0; sample < 5; ++sample) {
+        auto start = std::chrono::steady_clock::now();
+        body(ops);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (sample == 0 || ns < best) best = ns;
+    }
+    alloc::Scope scope;
+    body(ops);
+    return {best / ops, static_cast<double>(scope.elapsed().allocations) / ops};
+}
+
+std::vector<std::string> relayedMessages() {
+    Event event = parseEventsFile(DATA_DIR + "events1.json").events.front();
+    std::vector<std::string> frames;
+    for (int i = 0; i < 64; ++i) {
+        Event copy = event;
+        copy.set_event_owner("reporter" + std::to_string(i % 4));
+        frames.push_back(bench::makeMessageFrame(copy, i));
+    }
+    return frames;
+}
+
+std::map<std::string, Measurement> runPerfCases() {
+    std::map<std::string, Measurement> results;
+    CapturedOutput mute;
+
+    {
+        MemoryBroker broker;
+        StompProtocol bob;
+        broker.input(bob, "login 127.0.0.1:7777 bob pass");
+        broker.input(bob, "join Germany_Japan");
+        std::vector<std::string> frames = relayedMessages();
+        std::size_t next = 0;
+        results["protocol.processResponse.message"] = measure(2000, [&](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                bob.processResponse(frames[next]);
+                next = (next + 1) % frames.size();
+            }
+        });
+    }
+
+    {
+        std::vector<Event> events = parseEventsFile(DATA_DIR + "events1.json").events;
+        std::string out;
+        results["frame.encodeReport"] = measure(5000, [&](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                const Event& event = events[i % events.size()];
+                out.clear();
+                appendReportFrame(out, "Germany_Japan", "alice", event);
+            }
+        });
+    }
+
+    {
+        std::string path = DATA_DIR + "events1.json";
+        results["events.parseEventsFile"] = measure(200, [&](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) parseEventsFile(path);
+        });
+    }
+
+    {
+        MemoryBroker broker;
+        StompProtocol alice;
+        broker.input(alice, "login 127.0.0.1:7777 alice pass");
+        broker.input(alice, "join Germany_Japan");
+        broker.input(alice, "report " + DATA_DIR + "events1.json");
+        std::string path = tempPath("perf_summary.txt");
+        std::string command = "summary Germany_Japan alice " + path;
+        results["protocol.summary"] = measure(200, [&](std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) broker.input(alice, command);
+        });
+        std::remove(path.c_str());
+    }
+    return results;
+}
+
+struct Options {
+    Options() : baselinePath("perf_baseline.json"), updateBaseline(false), perf(true), timeTolerance(50),
+                allocTolerance(5) {}
+    std::string baselinePath;
+    bool updateBaseline;
+    bool perf;
+    double timeTolerance;
+    double allocTolerance;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--update-baseline") options.updateBaseline = true;
+        else if (arg == "--no-perf") options.perf = false;
+        else if (arg == "--baseline" && i + 1 < argc) options.baselinePath = argv[++i];
+        else if (arg == "--time-tolerance" && i + 1 < argc) options.timeTolerance = std::atof(argv[++i]);
+        else if (arg == "--alloc-tolerance" && i + 1 < argc) options.allocTolerance = std::atof(argv[++i]);
+        else return false;
+    }
+    return options.timeTolerance >= 0 && options.allocTolerance >= 0;
+}
+
+bool writeBaseline(const std::string& path, const std::map<std::string, Measurement>& results) {
+    nlohmann::json baseline;
+    baseline["schema"] = "stomp-perf-baseline/1";
+    for (const auto& result : results) {
+        baseline["cases"][result.first] = {{"ns_per_op", bench::rounded(result.second.nsPerOp)},
+                                           {"allocs_per_op", bench::rounded(result.second.allocsPerOp)}};
+    }
+    std::ofstream out(path);
+    out << baseline.dump(2) << std::endl;
+    return static_cast<bool>(out);
+}
+
+// Prints one line per case; returns the number of regressions.
+int compareWithBaseline(const Options& options, const std::map<std::string, Measurement>& results) {
+    nlohmann::json baseline;
+    try {
+        baseline = nlohmann::json::parse(readFile(options.baselinePath));
+    } catch (const std::exception&) {
+        std::cerr << "No usable baseline at " << options.baselinePath << "; run with --update-baseline" << std::endl;
+        return 1;
+    }
+
+    int regressions = 0;
+    for (const auto& result : results) {
+        const Measurement& now = result.second;
+        std::cout << "  " << result.first << ": " << bench::rounded(now.nsPerOp) << " ns/op, " << bench::rounded(now.allocsPerOp)
+                  << " allocs/op";
+        if (!baseline["cases"].contains(result.first)) {
+            std::cout << " (not in baseline)" << std::endl;
+            continue;
+        }
+        const nlohmann::json& expected = baseline["cases"][result.first];
+        double ns = expected["ns_per_op"].get<double>();
+        double allocs = expected["allocs_per_op"].get<double>();
+        std::cout << " (baseline " << ns << " ns, " << allocs << " allocs)";
+        // Half an allocation of slack keeps tiny counts from failing on rounding.
+        bool slower = now.nsPerOp > ns * (1 + options.timeTolerance / 100);
+        bool moreAllocs = now.allocsPerOp > allocs * (1 + options.allocTolerance / 100) + 0.5;
+        if (slower) std::cout << " SLOWER";
+        if (moreAllocs) std::cout << " MORE ALLOCATIONS";
+        std::cout << std::endl;
+        if (slower || moreAllocs) ++regressions;
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: run_tests [--baseline path] [--update-baseline] [--no-perf] "
+                     "[--time-tolerance percent] [--alloc-tolerance percent]"
+                  << std::endl;
+        return 2;
+    }
+
+    const std::pair<const char*, void (*)()> scenarios[] = {
+        {"login, join, report, summary", testLoginJoinReportSummary},
+        {"over the loopback broker", testOverLoopbackBroker},
+        {"summary waits for milestones", testSummaryWaitsForMilestones},
+        {"commands need login", testCommandsNeedLogin},
+        {"exit and logout", testExitAndLogout},
+        {"server error ends the session", testServerErrorEndsSession},
+        {"subscription filters", testSubscriptionFilters},
+        {"query index updates", testQueryIndexUpdates},
+        {"event log recovery", testEventLogRecovery},
+    };
+    for (const auto& scenario : scenarios) {
+        int before = failures;
+        scenario.second();
+        std::cout << (failures == before ? "ok     " : "FAILED ") << scenario.first << std::endl;
+    }
+    if (failures > 0) {
+        std::cout << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    if (!options.perf) return 0;
+
+    if (!alloc::enabled()) std::cerr << "warning: built without allocation accounting" << std::endl;
+    std::map<std::string, Measurement> results = runPerfCases();
+    if (options.updateBaseline) {
+        if (!writeBaseline(options.baselinePath, results)) {
+            std::cerr << "Could not write " << options.baselinePath << std::endl;
+            return 1;
+        }
+        std::cout << "baseline written to " << options.baselinePath << std::endl;
+        return 0;
+    }
+
+    std::cout << "perf (tolerance: time +" << options.timeTolerance << "%, allocations +" << options.allocTolerance
+              << "%):" << std::endl;
+    int regressions = compareWithBaseline(options, results);
+    if (regressions > 0) {
+        std::cout << regressions << " perf regression(s)" << std::endl;
+        return 1;
+    }
+    std::cout << "all tests passed" << std::endl;
+    return 0;
+}